@@ -1,39 +1,78 @@
 #include "Chip8.hpp"
 
+#include <bit>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <qstringview.h>
+#include <random>
 #include <string>
 
 #include <QThread>
 #include <QElapsedTimer>
+#include <QMutexLocker>
 
-bool Chip8::drawFlag;
-
-uint8_t         Chip8::soundTimer;
-QReadWriteLock  Chip8::soundTimerLock;
-uint8_t         Chip8::delayTimer;
-QReadWriteLock  Chip8::delayTimerLock;
-
-bool        Chip8::isWaitingForKeyboardInput;
-bool        Chip8::paused;
-bool        Chip8::alive;
+#include "Debugger.hpp"
+#include "NetplaySession.hpp"
+#include "Profiler.hpp"
+#include "SharedStateExporter.hpp"
+#include "StatePool.hpp"
 
 
 Chip8::Chip8() : 
-    memory(std::make_shared<Memory>()),
-    screen(std::make_shared<Screen>())
+    clockScale(1.0),
+    displayWait(false),
+    recorder(nullptr),
+    netplay(nullptr),
+    debugger(nullptr),
+    profiler(nullptr),
+    sharedState(nullptr)
     {
     paused = false;
     alive = false;
-    std::srand(time(nullptr));
+    keysDown = 0;
+    seed(std::random_device{}());
     clear();
 }
 
-void Chip8::loadFile(const QByteArray& fileContent) {
-    memory->loadFile(fileContent);
+void Chip8::seed(const uint32_t seed) {
+    // xorshift32 gets stuck on 0
+    rngSeed = seed != 0 ? seed : 1;
+    rngState = rngSeed;
+}
+
+bool Chip8::loadFile(const QByteArray& fileContent) {
+    return memory.loadFile(fileContent);
+}
+
+bool Chip8::loadFile(const uint8_t* data, const size_t size) {
+    return memory.loadFile(data, size);
+}
+
+void Chip8::setRecorder(FrameRecorder* frameRecorder) {
+    QMutexLocker locker(&frameMutex);
+    recorder = frameRecorder;
+}
+
+void Chip8::setNetplaySession(NetplaySession* session) {
+    QMutexLocker locker(&frameMutex);
+    netplay = session;
+}
+
+void Chip8::setDebugger(Debugger* attachedDebugger) {
+    QMutexLocker locker(&frameMutex);
+    debugger = attachedDebugger;
+}
+
+void Chip8::setProfiler(Profiler* attachedProfiler) {
+    QMutexLocker locker(&frameMutex);
+    profiler = attachedProfiler;
+}
+
+void Chip8::setSharedStateExporter(SharedStateExporter* exporter) {
+    QMutexLocker locker(&frameMutex);
+    sharedState = exporter;
 }
 
 void Chip8::restart() {
@@ -60,36 +99,80 @@ void Chip8::clear() {
         return;
     isWaitingForKeyboardInput = false;
     nCycle = 0;
+    cycleBalance = 0;
+    frameStopped = false;
+    crashed = false;
     pc = Memory::programBegin;
     opcode = 0;
     I = 0;
     sp = 0;
+    keypad = 0;
+    rngState = rngSeed;
     drawFlag = false;
-
-    soundTimerLock.lockForWrite();
     soundTimer = 0;
-    soundTimerLock.unlock();
-    delayTimerLock.lockForWrite();
     delayTimer = 0;
-    delayTimerLock.unlock();
 
     std::fill(std::begin(stack), std::end(stack), 0);
     std::fill(std::begin(V), std::end(V), 0);
 }
 
 void Chip8::updateTimers() {
-    if (paused || !alive)
-        return;
-    if(soundTimer > 0) {
-        soundTimerLock.lockForWrite();
+    if(soundTimer > 0)
         soundTimer--;
-        soundTimerLock.unlock();
-    }
-    if(delayTimer > 0) {
-        delayTimerLock.lockForWrite();
+    if(delayTimer > 0)
         delayTimer--;
-        delayTimerLock.unlock();
-    }
+}
+
+uint8_t Chip8::random() {
+    // xorshift32, seeded per instance so that netplay peers generate the same numbers
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState >> 24;
+}
+
+void Chip8::saveState(State& state) {
+    state.pc = pc;
+    state.I = I;
+    state.sp = sp;
+    std::copy(std::begin(V), std::end(V), std::begin(state.V));
+    std::copy(std::begin(stack), std::end(stack), std::begin(state.stack));
+    state.delayTimer = delayTimer;
+    state.soundTimer = soundTimer;
+    state.isWaitingForKeyboardInput = isWaitingForKeyboardInput;
+    state.rngState = rngState;
+    state.cycleBalance = cycleBalance;
+    state.memory = memory.getBytes();
+    state.frame = screen.getFrame();
+}
+
+void Chip8::snapshot(State& state) {
+    QMutexLocker locker(&frameMutex);
+    saveState(state);
+}
+
+Chip8::State* Chip8::fork(StatePool& pool) {
+    State* child = pool.allocate();
+    if(child != nullptr)
+        saveState(*child);
+    return child;
+}
+
+void Chip8::loadState(const State& state) {
+    pc = state.pc;
+    I = state.I;
+    sp = state.sp;
+    std::copy(std::begin(state.V), std::end(state.V), std::begin(V));
+    std::copy(std::begin(state.stack), std::end(state.stack), std::begin(stack));
+    delayTimer = state.delayTimer;
+    soundTimer = state.soundTimer;
+    isWaitingForKeyboardInput = state.isWaitingForKeyboardInput;
+    rngState = state.rngState;
+    cycleBalance = state.cycleBalance;
+    frameStopped = false;   // states are saved between frames
+    crashed = false;
+    memory.setBytes(state.memory);
+    screen.setFrame(state.frame);
 }
 
 void Chip8::drawSprite(
@@ -102,7 +185,7 @@ void Chip8::drawSprite(
     for(uint16_t i = 0; i < n; ++i) {
 
         uint16_t yrow = (V[y] % Screen::yRes_) + i;
-        uint8_t row = (*memory)[I+i];
+        uint8_t row = memory[I+i];
 
         if(yrow >= Screen::yRes_)
             continue;
@@ -115,19 +198,23 @@ void Chip8::drawSprite(
             if(xcol >= Screen::xRes_)
                 continue;
 
-            bool pixel = screen->getPixel(xcol, yrow);
+            bool pixel = screen.getPixel(xcol, yrow);
             if(pixel == true && currbit)
                 VF = 1;
 
-            Screen::setPixel(xcol, yrow, pixel ^ currbit);
+            screen.setPixel(xcol, yrow, pixel ^ currbit);
         }
     }
 }
 
 void Chip8::emulateCycle() {
-    if(paused || !alive || !memory->isFileLoaded())
+    if(paused || !alive || crashed || !memory.isFileLoaded())
         return;
-    opcode = memory->getOpcode(pc);
+    executeInstruction();
+}
+
+void Chip8::executeInstruction() {
+    opcode = memory.getOpcode(pc);
     pc += 2;
     drawFlag = false;
 
@@ -147,7 +234,7 @@ void Chip8::emulateCycle() {
         case 0x0000:
             switch (n) { // check nibble
                 case 0x0000: // 0x00E0: Clear screen
-                    screen->clear();
+                    screen.clear();
                     drawFlag = true;
                     break;
                 case 0x000E: // 0x00EE: Return from subroutine
@@ -247,8 +334,7 @@ void Chip8::emulateCycle() {
             pc = nnn + V[0];
             break;
         case 0xC000: // 0xCXKK: V[X] = random byte AND KK
-            // TODO: Replace rand() with something else
-            V[x] = (rand() % 256) & kk;
+            V[x] = random() & kk;
             break;
         case 0xD000: // 0xDXYN: Display n-byte sprite starting at memory location I at (V[X], V[Y]), V[F] = collision;
             drawSprite(n, x, y, VF);
@@ -257,11 +343,11 @@ void Chip8::emulateCycle() {
         case 0xE000:
             switch(kk){
                 case 0x009E: // 0xEX9E: Skip next instr. if key with the value of V[X] is pressed
-                    if(keysDown.contains(V[x]))
+                    if(isKeyDown(V[x]))
                         pc += 2;
                     break;
                 case 0x00A1: // 0xEXA1: Skip next instr. if key with the value of V[X] is NOT pressed
-                    if(!keysDown.contains(V[x]))
+                    if(!isKeyDown(V[x]))
                         pc += 2;
                     break;
                 default:
@@ -272,31 +358,23 @@ void Chip8::emulateCycle() {
         case 0xF000:
             switch(opcode & 0x00FF){
                 case 0x0007: // 0xFX07: V[X] = delayTimer
-                    delayTimerLock.lockForRead();
                     V[x] = delayTimer;
-                    delayTimerLock.unlock();
                     break;
                 case 0x000A: // 0xFX0A: Wait for a key press, store the value of the key in V[X]
-                    isWaitingForKeyboardInput = keysDown.empty();
+                    isWaitingForKeyboardInput = keypad == 0;
 
                     if(isWaitingForKeyboardInput) {
                         pc -= 2;
                     }
                     else {
-                        keysDownLock.lockForRead();
-                        V[x] = *keysDown.begin();
-                        keysDownLock.unlock();
+                        V[x] = std::countr_zero(keypad);
                     }
                     break;
                 case 0x0015: // 0xFX15: delayTimer = V[X]
-                    delayTimerLock.lockForWrite();
                     delayTimer = V[x];
-                    delayTimerLock.unlock();
                     break;
                 case 0x0018: // 0xFX18: soundTimer = V[X]
-                    soundTimerLock.lockForWrite();
                     soundTimer = V[x];
-                    delayTimerLock.unlock();
                     break;
                 case 0x001E: // 0xFX1E: I = I + V[X]
                     I = I + V[x];
@@ -305,17 +383,17 @@ void Chip8::emulateCycle() {
                     I = 4 * V[x];
                     break;
                 case 0x0033: // 0xFX33: Store BCD representation of V[X] in memory locations I, I+1 and I+2
-                    (*memory)[I] = V[x] / 100; // ones
-                    (*memory)[I+1] = (V[x] / 10) % 10; // tens
-                    (*memory)[I+2] = (V[x] % 100) % 10; // hundreds
+                    memory[I] = V[x] / 100; // ones
+                    memory[I+1] = (V[x] / 10) % 10; // tens
+                    memory[I+2] = (V[x] % 100) % 10; // hundreds
                     break;
                 case 0x0055: // 0xFX55: Store registers V[0x0] through V[X] in memory starting at location I
                     for(uint8_t i = 0; i <= x; ++i, ++I)
-                        (*memory)[I] = V[i];
+                        memory[I] = V[i];
                     break;
                 case 0x0065: // 0xFX65: Read registers V[0x0] through V[X] from memory starting at location I
                     for(uint8_t i = 0; i <= x; ++i, ++I)
-                        V[i] = (*memory)[I];
+                        V[i] = memory[I];
                     break;
                 default:
                     unknownOpcode(opcode);
@@ -327,20 +405,18 @@ void Chip8::emulateCycle() {
             break; 
     }
     
-    soundTimerLock.lockForRead();
     if(soundTimer == 1) {
         std::cout << "BEEP!\a" << std::endl;
     }
-    soundTimerLock.unlock();
 
     nCycle++;
 }
 
 void Chip8::run() {
-    if(!memory->isFileLoaded())
+    if(!memory.isFileLoaded())
         return;
     clear();
-    screen->clear();
+    screen.clear();
 
     paused = false;
     alive = true;
@@ -357,17 +433,120 @@ void Chip8::run() {
             deltaTime = 1000000000;
 
         accuTime += deltaTime;
-        for(;accuTime >= 16670000; accuTime -= 16670000) {
-            for(size_t i = 0; i < 8; ++i) {
-                emulateCycle();
+        for(;accuTime >= Timing::frameDuration_ns; accuTime -= Timing::frameDuration_ns) {
+            if(paused)
+                continue;
+            QMutexLocker locker(&frameMutex);
+
+            // keys pressed by an external process count as local keys
+            SharedStateExporter* exporter = sharedState.load();
+            const uint16_t keys = keysDown | (exporter != nullptr ? exporter->getKeys() : 0);
+
+            if(NetplaySession* session = netplay.load())
+                session->advanceFrame(keys);
+            else
+                emulateFrame(keys);
+
+            if(exporter != nullptr)
+                exporter->publish(*this);
+
+            if(FrameRecorder* frameRecorder = recorder.load())
+                frameRecorder->pushFrame(screen.getFrame());
+
+            if(crashed) {
+                printf("Unknown opcode: 0x%04x at 0x%03x, emulator stopped\n", memory.getOpcode(pc), pc);
+                alive = false;
+                break;
+            }
+        }
+    }
+}
+
+void Chip8::emulateFrame(const uint16_t keys) {
+    // stop() ends the emulation thread's frames, e.g. a netplay resimulation. Headless instances
+    // (StateExplorer workers) never run() and are not alive, they emulate whenever they are asked to.
+    if(paused || (!alive && isRunning()) || crashed || !memory.isFileLoaded())
+        return;
+    keypad = keys;
+
+    // Spend this frame's VIP cycle budget. Overspending (e.g. 00E0) is carried over as debt into the next frame.
+    // A frame the debugger stopped in gets no new budget, it continues where it stopped.
+    if(!frameStopped)
+        cycleBalance += getFrameBudget();
+    frameStopped = false;
+
+    // Decided once per frame, without breakpoints, watchpoints or profiling the loop has no checks at all
+    Debugger* activeDebugger = debugger.load();
+    if(activeDebugger != nullptr && !activeDebugger->isArmed())
+        activeDebugger = nullptr;
+    Profiler* activeProfiler = profiler.load();
+    if(activeProfiler != nullptr && !activeProfiler->isRunning())
+        activeProfiler = nullptr;
+
+    if(activeProfiler != nullptr)
+        activeProfiler->beginFrame();
+
+    if(activeDebugger != nullptr && activeProfiler != nullptr)
+        spendCycles<true, true>(activeDebugger, activeProfiler);
+    else if(activeDebugger != nullptr)
+        spendCycles<true, false>(activeDebugger, nullptr);
+    else if(activeProfiler != nullptr)
+        spendCycles<false, true>(nullptr, activeProfiler);
+    else
+        spendCycles<false, false>(nullptr, nullptr);
+
+    if(crashed)
+        return;
+
+    // Paused with cycles left = stopped before an instruction of this frame (breakpoint, step, pause). The frame
+    // is not over, so the timers keep their value until its budget is used up.
+    if(paused && cycleBalance > 0) {
+        frameStopped = true;
+        return;
+    }
+
+    // Unused cycles are spent spinning, only the debt carries over
+    if(cycleBalance > 0)
+        cycleBalance = 0;
+
+    updateTimers();
+}
+
+template<bool Debugged, bool Profiled>
+void Chip8::spendCycles(Debugger* activeDebugger, Profiler* activeProfiler) {
+    bool firstInFrame = true;
+    while(cycleBalance > 0 && !paused) {
+        const uint16_t nextOpcode = memory.getOpcode(pc);
+
+        // Display wait: the VIP interpreter waits for vblank before drawing, so DXYN has to start a frame
+        if(displayWait && !firstInFrame && (nextOpcode & 0xF000) == 0xD000)
+            break;
+
+        // the debugger stops before the instruction, it executes once the debugger resumes
+        if constexpr(Debugged) {
+            if(activeDebugger->check(nextOpcode)) {
+                paused = true;
+                break;
             }
         }
+
+        const uint32_t cost = Timing::instructionCost(nextOpcode);
+        if constexpr(Profiled)
+            activeProfiler->record(pc, nextOpcode, cost);
+
+        cycleBalance -= cost;
+        executeInstruction();
+        firstInFrame = false;
     }
 }
 
 void Chip8::unknownOpcode(const uint16_t& opcode) {
-    printf("Unknown opcode: 0x%04x\n", opcode);
-    exit(2);
+    // Only this instance stops, e.g. one StateExplorer branch that jumped into data. pc stays on the opcode and
+    // the balance is cleared so spendCycles() ends the frame.
+    Q_UNUSED(opcode)
+    crashed = true;
+    pc -= 2;
+    cycleBalance = 0;
 }
 
 void Chip8::printData(
@@ -383,14 +562,10 @@ void Chip8::printData(
 }
 
 void Chip8::addKeyDown(const unsigned char& keyVal) {
-    keysDownLock.lockForWrite();
-    keysDown.insert(keyVal);
-    keysDownLock.unlock();
+    keysDown |= 1 << keyVal;
 }
 
 void Chip8::removeKeyDown(const unsigned char& keyVal) {
-    keysDownLock.lockForWrite();
-    keysDown.erase(keyVal);
-    keysDownLock.unlock();
+    keysDown &= ~(1 << keyVal);
 }
 
@@ -1,35 +1,84 @@
 #ifndef CHIP8_HPP
 #define CHIP8_HPP
 
+#include <atomic>
 #include <cstdint>
-#include <set>
 
+#include <QMutex>
 #include <QThread>
-#include <QReadWriteLock>
 
 #include "Screen.hpp"
 #include "Memory.hpp"
+#include "Timing.hpp"
+#include "FrameRecorder.hpp"
+
+class Debugger;
+class NetplaySession;
+class Profiler;
+class SharedStateExporter;
+class StatePool;
 
 class Chip8 : public QThread {
     Q_OBJECT
 public:
+    // Everything that changes while emulating, trivially copyable so it can be saved and restored in one copy
+    struct State {
+        uint16_t        pc;
+        uint16_t        I;
+        uint16_t        sp;
+        uint8_t         V[16];
+        uint16_t        stack[16];
+        uint8_t         delayTimer;
+        uint8_t         soundTimer;
+        bool            isWaitingForKeyboardInput;
+        uint32_t        rngState;
+        int64_t         cycleBalance;
+        Memory::Bytes   memory;
+        Screen::Frame   frame;
+    };
+
     Chip8();
     ~Chip8() = default;
 
-    inline Memory& getMemory() { return *memory; }
-    inline Screen& getScreen() { return *screen; }
-    static inline bool getDrawFlag() { return drawFlag; }
+    inline Memory& getMemory() { return memory; }
+    inline Screen& getScreen() { return screen; }
+    inline bool getDrawFlag() { return drawFlag; }
     inline bool getIsWaitingForKeyboardInput() { return isWaitingForKeyboardInput; }
+    inline uint16_t getPc() { return pc; }
+    inline uint16_t getI() { return I; }
+    inline uint16_t getSp() { return sp; }
+    inline uint8_t getV(const uint8_t r) { return V[r]; }
+    inline uint16_t getStack(const uint8_t level) { return stack[level]; }
     inline uint8_t getDelayTimer() { return delayTimer; }
     inline uint8_t getSoundTimer() { return soundTimer; }
     inline bool isPaused() { return paused; }
     inline bool isAlive() { return alive; }
-    static void updateTimers();
+    inline bool isCrashed() { return crashed; }
+    inline double getClockScale() { return clockScale; }
+    inline void setClockScale(const double scale) { clockScale = scale; }
+    inline int64_t getFrameBudget() { return static_cast<int64_t>(Timing::frameBudget * clockScale); } // VIP cycles
+    inline bool getDisplayWait() { return displayWait; }
+    inline void setDisplayWait(const bool enabled) { displayWait = enabled; }
+    void setRecorder(FrameRecorder* frameRecorder); // waits for the frame in progress, see frameMutex
+    void setNetplaySession(NetplaySession* session); // waits for the frame in progress
+    void setDebugger(Debugger* attachedDebugger); // waits for the frame in progress
+    void setProfiler(Profiler* attachedProfiler); // waits for the frame in progress
+    void setSharedStateExporter(SharedStateExporter* exporter); // waits for the frame in progress
+    inline uint32_t getSeed() { return rngSeed; }
+    void seed(const uint32_t seed);
     void addKeyDown(const unsigned char& keyVal);
     void removeKeyDown(const unsigned char& keyVal);
+    inline uint16_t getKeysDown() { return keysDown; }
+
+    void saveState(State& state);
+    void snapshot(State& state); // saveState() between two frames of run(), for other threads
+    void loadState(const State& state);
+    State* fork(StatePool& pool); // nullptr when the pool is exhausted
     
-    void loadFile(const QByteArray& fileContent);
+    bool loadFile(const QByteArray& fileContent);
+    bool loadFile(const uint8_t* data, const size_t size);
     void emulateCycle();
+    void emulateFrame(const uint16_t keys); // keys: bit k set = key k is down for the whole frame
     void clear();
     
     // emulator control 
@@ -41,6 +90,10 @@ public:
  
 private: 
     size_t      nCycle;
+    int64_t     cycleBalance;   // VIP machine cycles left in the current frame (negative = overspent)
+    bool        frameStopped;   // the debugger stopped inside the frame, it continues with the cycles left
+    double      clockScale;     // multiplier of Timing::frameBudget (1.0 = COSMAC VIP speed)
+    bool        displayWait;    // DXYN only allowed as the first instruction of a frame
     uint16_t    lastX;
     uint16_t    pc;      // program counter
     uint16_t    opcode;  // current opcode (opcodes are 2 bytes)
@@ -48,26 +101,40 @@ private:
     uint16_t    sp;      // stack pointer
     uint8_t     V[16];    // 16 * 1 byte registers (VF is carry flag)
     uint16_t    stack[16];
-    uint8_t     key[16];
-    static bool drawFlag;
+    uint16_t    keypad;  // keys latched at the start of the frame
+    uint32_t    rngSeed;
+    uint32_t    rngState;
+    bool        drawFlag;
 
-    static uint8_t         soundTimer;
-    static QReadWriteLock  soundTimerLock;
-    static uint8_t         delayTimer;
-    static QReadWriteLock  delayTimerLock;
+    uint8_t     soundTimer;
+    uint8_t     delayTimer;
 
-    static bool        isWaitingForKeyboardInput;
-    static bool        paused;
-    static bool        alive;
+    bool        isWaitingForKeyboardInput;
+    std::atomic<bool> paused;   // pause() / unPause() are called from the GUI thread
+    std::atomic<bool> alive;    // written by stop() from other threads
+    bool        crashed;        // executed an unknown opcode, stays stopped until clear() or loadState()
 
-    std::set<char> keysDown;
-    QReadWriteLock keysDownLock;
+    std::atomic<uint16_t> keysDown;
 
     std::string ROMFileName;
 
-    std::shared_ptr<Memory> memory;
-    std::shared_ptr<Screen> screen;
+    Memory memory;
+    Screen screen;
+    // run() holds it for every frame, so a detached recorder / session / debugger / profiler / exporter is no
+    // longer in use once its setter returned and can be closed or destroyed
+    QMutex frameMutex;
+    std::atomic<FrameRecorder*> recorder;
+    std::atomic<NetplaySession*> netplay;
+    std::atomic<Debugger*> debugger;
+    std::atomic<Profiler*> profiler;
+    std::atomic<SharedStateExporter*> sharedState;
 
+    template<bool Debugged, bool Profiled>
+    void spendCycles(Debugger* activeDebugger, Profiler* activeProfiler);
+    void executeInstruction();
+    void updateTimers();
+    uint8_t random();
+    inline bool isKeyDown(const uint8_t key) { return key < 16 && (keypad >> key) & 1; }
     void unknownOpcode(const uint16_t& opcode);
     void drawSprite(
         const uint16_t& n,
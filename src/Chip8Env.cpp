@@ -0,0 +1,182 @@
+#include "Chip8Env.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "LockstepEngine.hpp"
+
+struct Chip8Env {
+    uint32_t count;
+    std::vector<std::unique_ptr<LockstepEngine>> engines; // engine e runs environments 32e to 32e+31
+};
+
+struct Chip8EnvSnapshot {
+    LockstepEngine::LaneState state;
+};
+
+namespace {
+
+constexpr uint32_t lanes = LockstepEngine::maxLanes;
+constexpr size_t bitsFrameSize = sizeof(LockstepEngine::Frame);
+constexpr size_t bytesFrameSize = LockstepEngine::xRes * LockstepEngine::yRes;
+constexpr double maxClockScale = 1000.0; // the per-frame cycle budget has to fit LockstepEngine's int32_t
+
+inline bool isSelected(const uint8_t* mask, const uint32_t i) {
+    return mask == nullptr || mask[i] != 0;
+}
+
+void writeFrame(const LockstepEngine::Frame& frame, uint8_t* out, const Chip8EnvFrameFormat format) {
+    if(format == CHIP8_ENV_FRAME_BITS) {
+        std::memcpy(out, frame.data(), bitsFrameSize);
+        return;
+    }
+    for(uint16_t y = 0; y < LockstepEngine::yRes; ++y) {
+        const uint64_t row = frame[y];
+        for(uint16_t x = 0; x < LockstepEngine::xRes; ++x)
+            out[y * LockstepEngine::xRes + x] = (row >> x) & 1;
+    }
+}
+
+}
+
+uint32_t chip8_env_api_version(void) {
+    return CHIP8_ENV_API_VERSION;
+}
+
+Chip8Env* chip8_env_create(const uint8_t* rom, const size_t romSize, const uint32_t count, const uint32_t seed) {
+    if(rom == nullptr || count == 0 || romSize > Memory::memorySize - Memory::programBegin)
+        return nullptr;
+
+    // no exception may cross the C ABI, a count too large to allocate is an invalid argument as well
+    try {
+        auto env = std::make_unique<Chip8Env>();
+        env->count = count;
+        for(uint32_t first = 0; first < count; first += lanes) {
+            auto engine = std::make_unique<LockstepEngine>(std::min(count - first, lanes));
+            // wraps around, LockstepEngine::seed replaces 0 by 1
+            for(uint32_t lane = 0; lane < engine->getLaneCount(); ++lane)
+                engine->seed(lane, seed + first + lane);
+            // loadRom resets, so the seeds are in place from the first frame
+            if(!engine->loadRom(rom, romSize))
+                return nullptr;
+            env->engines.push_back(std::move(engine));
+        }
+        return env.release();
+    }
+    catch(const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void chip8_env_destroy(Chip8Env* env) {
+    delete env;
+}
+
+uint32_t chip8_env_count(const Chip8Env* env) {
+    return env != nullptr ? env->count : 0;
+}
+
+int chip8_env_set_clock_scale(Chip8Env* env, const double scale) {
+    // also rejects NaN
+    if(env == nullptr || !(scale > 0 && scale <= maxClockScale))
+        return CHIP8_ENV_INVALID_ARGUMENT;
+    for(auto& engine : env->engines)
+        engine->setClockScale(scale);
+    return CHIP8_ENV_OK;
+}
+
+int chip8_env_set_display_wait(Chip8Env* env, const bool enabled) {
+    if(env == nullptr)
+        return CHIP8_ENV_INVALID_ARGUMENT;
+    for(auto& engine : env->engines)
+        engine->setDisplayWait(enabled);
+    return CHIP8_ENV_OK;
+}
+
+size_t chip8_env_frame_size(const Chip8EnvFrameFormat format) {
+    switch(format) {
+        case CHIP8_ENV_FRAME_BITS:  return bitsFrameSize;
+        case CHIP8_ENV_FRAME_BYTES: return bytesFrameSize;
+    }
+    return 0;
+}
+
+int chip8_env_step(Chip8Env* env, const uint16_t* keypads, const uint32_t repeat, void* frames,
+                   const Chip8EnvFrameFormat format) {
+    const size_t frameSize = chip8_env_frame_size(format);
+    if(env == nullptr || frameSize == 0)
+        return CHIP8_ENV_INVALID_ARGUMENT;
+
+    // engine by engine, so every engine's lanes stay in cache for all repeated frames
+    for(uint32_t e = 0; e < env->engines.size(); ++e) {
+        LockstepEngine& engine = *env->engines[e];
+        const uint32_t first = e * lanes;
+        for(uint32_t frame = 0; frame < repeat; ++frame)
+            engine.stepFrame(keypads != nullptr ? keypads + first : nullptr);
+
+        if(frames == nullptr)
+            continue;
+        uint8_t* out = static_cast<uint8_t*>(frames) + first * frameSize;
+        for(uint32_t lane = 0; lane < engine.getLaneCount(); ++lane)
+            writeFrame(engine.getFrame(lane), out + lane * frameSize, format);
+    }
+    return CHIP8_ENV_OK;
+}
+
+int chip8_env_is_crashed(const Chip8Env* env, const uint32_t i) {
+    if(env == nullptr)
+        return CHIP8_ENV_INVALID_ARGUMENT;
+    if(i >= env->count)
+        return CHIP8_ENV_OUT_OF_RANGE;
+    return env->engines[i / lanes]->isCrashed(i % lanes) ? 1 : 0;
+}
+
+int chip8_env_read_memory(const Chip8Env* env, const uint32_t i, const uint16_t address, uint8_t* out, const size_t size) {
+    if(env == nullptr || (out == nullptr && size != 0))
+        return CHIP8_ENV_INVALID_ARGUMENT;
+    // size is compared against what is left, address + size could wrap
+    if(i >= env->count || address >= Memory::memorySize || size > size_t(Memory::memorySize - address))
+        return CHIP8_ENV_OUT_OF_RANGE;
+
+    LockstepEngine& engine = *env->engines[i / lanes];
+    for(size_t offset = 0; offset < size; ++offset)
+        out[offset] = engine.peek(i % lanes, address + offset);
+    return CHIP8_ENV_OK;
+}
+
+int chip8_env_reset(Chip8Env* env, const uint8_t* mask) {
+    if(env == nullptr)
+        return CHIP8_ENV_INVALID_ARGUMENT;
+    for(uint32_t i = 0; i < env->count; ++i) {
+        if(isSelected(mask, i))
+            env->engines[i / lanes]->resetLane(i % lanes);
+    }
+    return CHIP8_ENV_OK;
+}
+
+int chip8_env_restore(Chip8Env* env, const Chip8EnvSnapshot* snapshot, const uint8_t* mask) {
+    if(env == nullptr || snapshot == nullptr)
+        return CHIP8_ENV_INVALID_ARGUMENT;
+    for(uint32_t i = 0; i < env->count; ++i) {
+        if(isSelected(mask, i))
+            env->engines[i / lanes]->loadLane(i % lanes, snapshot->state);
+    }
+    return CHIP8_ENV_OK;
+}
+
+Chip8EnvSnapshot* chip8_env_snapshot(const Chip8Env* env, const uint32_t i) {
+    if(env == nullptr || i >= env->count)
+        return nullptr;
+
+    Chip8EnvSnapshot* snapshot = new(std::nothrow) Chip8EnvSnapshot;
+    if(snapshot != nullptr)
+        env->engines[i / lanes]->saveLane(i % lanes, snapshot->state);
+    return snapshot;
+}
+
+void chip8_env_snapshot_destroy(Chip8EnvSnapshot* snapshot) {
+    delete snapshot;
+}
@@ -0,0 +1,90 @@
+#ifndef CHIP8_ENV_H
+#define CHIP8_ENV_H
+
+/* Stable C ABI for running many instances of one ROM, e.g. as reinforcement learning environments.
+     * + environments run on LockstepEngine, 32 per engine, without Qt
+     * + chip8_env_step() advances every environment with one call and writes all framebuffers into a buffer owned
+     *   by the caller, nothing is allocated after chip8_env_create()
+     * + environments are reset to power-on or restored from a snapshot, selected by a mask
+     * + a chip8_env is not thread-safe, but separate chip8_env objects can be stepped from separate threads
+     * + every argument is validated, functions returning int return a Chip8EnvStatus (negative = error) and
+     *   functions returning a pointer return NULL for invalid arguments*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define CHIP8_ENV_API __declspec(dllexport)
+#else
+#define CHIP8_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHIP8_ENV_API_VERSION   1
+#define CHIP8_ENV_WIDTH         64
+#define CHIP8_ENV_HEIGHT        32
+
+typedef enum Chip8EnvStatus {
+    CHIP8_ENV_OK               =  0,
+    CHIP8_ENV_INVALID_ARGUMENT = -1,    /* NULL env / snapshot / buffer, unknown frame format, bad clock scale */
+    CHIP8_ENV_OUT_OF_RANGE     = -2     /* environment index or memory range outside of the environment */
+} Chip8EnvStatus;
+
+typedef enum Chip8EnvFrameFormat {
+    CHIP8_ENV_FRAME_BITS  = 0,  /* 32 native uint64_t per frame, bit x of row y is pixel (x, y), 256 bytes */
+    CHIP8_ENV_FRAME_BYTES = 1   /* one byte per pixel (0 or 1), row major, 2048 bytes */
+} Chip8EnvFrameFormat;
+
+typedef struct Chip8Env Chip8Env;
+typedef struct Chip8EnvSnapshot Chip8EnvSnapshot;
+
+CHIP8_ENV_API uint32_t chip8_env_api_version(void);
+
+/* count environments of rom. Environment i is seeded with seed + i (mod 2^32), a seed that wraps to 0 is
+ * replaced by 1 since the random number generator gets stuck on 0. NULL if rom is NULL, count is 0 or the ROM
+ * does not fit. */
+CHIP8_ENV_API Chip8Env* chip8_env_create(const uint8_t* rom, size_t romSize, uint32_t count, uint32_t seed);
+CHIP8_ENV_API void chip8_env_destroy(Chip8Env* env);                   /* NULL is ignored */
+CHIP8_ENV_API uint32_t chip8_env_count(const Chip8Env* env);           /* 0 for NULL */
+
+/* Quirks, see Chip8::setClockScale (0 < scale <= 1000) and Chip8::setDisplayWait */
+CHIP8_ENV_API int chip8_env_set_clock_scale(Chip8Env* env, double scale);
+CHIP8_ENV_API int chip8_env_set_display_wait(Chip8Env* env, bool enabled);
+
+/* Bytes one frame takes in format (0 for an unknown format), the frames buffer of chip8_env_step() holds count
+ * of them */
+CHIP8_ENV_API size_t chip8_env_frame_size(Chip8EnvFrameFormat format);
+
+/* Emulates repeat frames of every environment with the same keys, bit k of keypads[i] = key k of environment i
+ * is down (keypads NULL = no keys). Then writes the last frame of every environment into frames (NULL = skip).
+ * keypads and frames have to hold chip8_env_count() entries. */
+CHIP8_ENV_API int chip8_env_step(Chip8Env* env, const uint16_t* keypads, uint32_t repeat,
+                                 void* frames, Chip8EnvFrameFormat format);
+
+/* 1 once environment i executed an unknown opcode, it stays stopped until it is reset or restored. 0 while it
+ * runs, negative for invalid arguments. */
+CHIP8_ENV_API int chip8_env_is_crashed(const Chip8Env* env, uint32_t i);
+
+/* Copies size bytes of the memory of environment i from address, e.g. to read a score. address + size must not
+ * exceed 4096. */
+CHIP8_ENV_API int chip8_env_read_memory(const Chip8Env* env, uint32_t i, uint16_t address, uint8_t* out, size_t size);
+
+/* Environments with mask[i] != 0 (mask NULL = all) go back to power-on, or to the state in snapshot. mask has
+ * to hold chip8_env_count() entries. */
+CHIP8_ENV_API int chip8_env_reset(Chip8Env* env, const uint8_t* mask);
+CHIP8_ENV_API int chip8_env_restore(Chip8Env* env, const Chip8EnvSnapshot* snapshot, const uint8_t* mask);
+
+/* State of environment i, can be restored into any environment of any Chip8Env running the same ROM.
+ * NULL if env is NULL or i is out of range. */
+CHIP8_ENV_API Chip8EnvSnapshot* chip8_env_snapshot(const Chip8Env* env, uint32_t i);
+CHIP8_ENV_API void chip8_env_snapshot_destroy(Chip8EnvSnapshot* snapshot); /* NULL is ignored */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHIP8_ENV_H */
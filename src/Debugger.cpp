@@ -0,0 +1,453 @@
+#include "Debugger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include <QMutexLocker>
+
+#include "Chip8.hpp"
+#include "StringFormat.hpp"
+
+namespace {
+
+const char* const helpText =
+    "break ADDR                 breakpoint at ADDR\n"
+    "break ADDR|* REG OP VALUE  stop at ADDR (or anywhere) when the condition holds, e.g. break * v3 == 5\n"
+    "watch ADDR[-END] [r|w|rw]  stop when an instruction reads / writes the range\n"
+    "unwatch ADDR[-END]         remove watchpoints\n"
+    "delete ADDR|*              remove everything set at ADDR (* = conditions without address)\n"
+    "clear                      remove everything\n"
+    "list                       show breakpoints, watchpoints and conditions\n"
+    "continue, step, pause      control the emulator\n"
+    "track on|off               count memory accesses per address\n"
+    "accesses ADDR[-END]        show counted reads and writes\n"
+    "Numbers are hex, REG is V0-VF, I, SP, DT or ST, OP is == != < <= > >=";
+
+bool parseNumber(std::string token, uint16_t& number, const uint32_t max) {
+    if(token.starts_with("0x"))
+        token.erase(0, 2);
+    if(token.empty() || token.size() > 4 || !std::all_of(token.begin(), token.end(), ::isxdigit))
+        return false;
+    const uint32_t value = std::stoul(token, nullptr, 16);
+    if(value > max)
+        return false;
+    number = value;
+    return true;
+}
+
+bool parseRange(const std::string& token, uint16_t& begin, uint16_t& end) {
+    const size_t dash = token.find('-');
+    if(dash == std::string::npos) {
+        if(!parseNumber(token, begin, Memory::memorySize - 1))
+            return false;
+        end = begin;
+        return true;
+    }
+    return parseNumber(token.substr(0, dash), begin, Memory::memorySize - 1)
+        && parseNumber(token.substr(dash + 1), end, Memory::memorySize - 1)
+        && begin <= end;
+}
+
+bool parseOperand(const std::string& token, uint8_t& operand) {
+    if(token.size() == 2 && token[0] == 'v' && std::isxdigit(token[1])) {
+        operand = std::stoul(token.substr(1), nullptr, 16);
+        return true;
+    }
+    if(token == "i")
+        operand = Debugger::RegisterI;
+    else if(token == "sp")
+        operand = Debugger::StackPointer;
+    else if(token == "dt")
+        operand = Debugger::DelayTimer;
+    else if(token == "st")
+        operand = Debugger::SoundTimer;
+    else
+        return false;
+    return true;
+}
+
+bool parseCompare(const std::string& token, Debugger::Compare& compare) {
+    using Compare = Debugger::Compare;
+    if(token == "==")
+        compare = Compare::Equal;
+    else if(token == "!=")
+        compare = Compare::NotEqual;
+    else if(token == "<")
+        compare = Compare::Less;
+    else if(token == "<=")
+        compare = Compare::LessEqual;
+    else if(token == ">")
+        compare = Compare::Greater;
+    else if(token == ">=")
+        compare = Compare::GreaterEqual;
+    else
+        return false;
+    return true;
+}
+
+std::string formatCondition(const Debugger::Condition& condition) {
+    static const char* const compares[] = { "==", "!=", "<", "<=", ">", ">=" };
+    static const char* const operands[] = { "I", "SP", "DT", "ST" };
+
+    const std::string address = condition.address == Debugger::anyAddress ? "*" : format("0x%03X", condition.address);
+    const std::string operand = condition.operand < 16
+        ? format("V%X", condition.operand)
+        : operands[condition.operand - Debugger::RegisterI];
+    return format("%s: %s %s 0x%X", address.c_str(), operand.c_str(),
+        compares[static_cast<int>(condition.compare)], condition.value);
+}
+
+}
+
+Debugger::Debugger(Chip8& target) :
+    chip8(target),
+    flags {},
+    readCount {},
+    writeCount {},
+    lastHit { Reason::None, 0, 0 },
+    armed(false),
+    watching(false),
+    tracking(false),
+    stepping(false),
+    skipNext(false),
+    hasGlobalConditions(false) {
+}
+
+void Debugger::setBreakpoint(const uint16_t address, const bool enabled) {
+    if(enabled)
+        flags[address & 0xFFF] |= Breakpoint;
+    else
+        flags[address & 0xFFF] &= ~Breakpoint;
+    updateArmed();
+}
+
+void Debugger::setWatch(const uint16_t begin, const uint16_t end, const uint8_t watchFlags, const bool enabled) {
+    const uint8_t watch = watchFlags & (ReadWatch | WriteWatch);
+    for(uint32_t address = begin; address <= end && address < Memory::memorySize; ++address) {
+        if(enabled)
+            flags[address] |= watch;
+        else
+            flags[address] &= ~watch;
+    }
+    updateArmed();
+}
+
+void Debugger::addCondition(const Condition& condition) {
+    mutex.lock();
+    conditions.push_back(condition);
+    mutex.unlock();
+    if(condition.address != anyAddress)
+        flags[condition.address & 0xFFF] |= Conditional;
+    updateArmed();
+}
+
+void Debugger::clearAddress(const uint16_t address) {
+    mutex.lock();
+    std::erase_if(conditions, [address](const Condition& condition) { return condition.address == address; });
+    mutex.unlock();
+    if(address != anyAddress)
+        flags[address & 0xFFF] = 0;
+    updateArmed();
+}
+
+void Debugger::clearAll() {
+    mutex.lock();
+    conditions.clear();
+    mutex.unlock();
+    for(auto& flag : flags)
+        flag = 0;
+    updateArmed();
+}
+
+void Debugger::setTracking(const bool enabled) {
+    if(enabled && !tracking) {
+        for(uint16_t address = 0; address < Memory::memorySize; ++address) {
+            readCount[address] = 0;
+            writeCount[address] = 0;
+        }
+    }
+    tracking = enabled;
+    updateArmed();
+}
+
+void Debugger::resume() {
+    mutex.lock();
+    // the instruction it stopped at must not stop it again. Unarmed, check() is not called, a skip set now
+    // would swallow the first check after re-arming instead.
+    skipNext = lastHit.reason != Reason::None && isArmed();
+    lastHit.reason = Reason::None;
+    mutex.unlock();
+    chip8.unPause();
+}
+
+void Debugger::step() {
+    mutex.lock();
+    lastHit.reason = Reason::None;
+    mutex.unlock();
+    skipNext = true;
+    stepping = true;
+    updateArmed();
+    chip8.unPause();
+}
+
+Debugger::Hit Debugger::getLastHit() {
+    QMutexLocker locker(&mutex);
+    return lastHit;
+}
+
+bool Debugger::check(const uint16_t opcode) {
+    const uint16_t pc = chip8.getPc() & 0xFFF;
+    const uint16_t I = chip8.getI();
+    const uint16_t x = (opcode & 0x0F00) >> 8;
+
+    // bytes the instruction is going to access
+    uint8_t access = 0;
+    uint16_t count = 0;
+    if((opcode & 0xF000) == 0xD000) {
+        access = ReadWatch;
+        count = opcode & 0x000F;
+    }
+    else if((opcode & 0xF0FF) == 0xF033) {
+        access = WriteWatch;
+        count = 3;
+    }
+    else if((opcode & 0xF0FF) == 0xF055) {
+        access = WriteWatch;
+        count = x + 1;
+    }
+    else if((opcode & 0xF0FF) == 0xF065) {
+        access = ReadWatch;
+        count = x + 1;
+    }
+
+    // only instructions which go on to execute are counted
+    auto execute = [&] {
+        if(tracking.load(std::memory_order_relaxed)) {
+            auto& counts = access == ReadWatch ? readCount : writeCount;
+            for(uint16_t i = 0; i < count; ++i)
+                counts[(I + i) & 0xFFF].fetch_add(1, std::memory_order_relaxed);
+        }
+        return false;
+    };
+
+    if(skipNext.load(std::memory_order_relaxed)) {
+        skipNext = false;
+        return execute();
+    }
+    if(stepping.load(std::memory_order_relaxed)) {
+        stepping = false;
+        updateArmed();
+        return stop({ Reason::Step, pc, pc });
+    }
+
+    const uint8_t pcFlags = flags[pc].load(std::memory_order_relaxed);
+    if(pcFlags & Breakpoint)
+        return stop({ Reason::Breakpoint, pc, pc });
+
+    if((pcFlags & Conditional) || hasGlobalConditions.load(std::memory_order_relaxed)) {
+        mutex.lock();
+        const bool hit = std::any_of(conditions.begin(), conditions.end(), [this, pc](const Condition& condition) {
+            return (condition.address == pc || condition.address == anyAddress) && evaluate(condition);
+        });
+        mutex.unlock();
+        if(hit)
+            return stop({ Reason::Condition, pc, pc });
+    }
+
+    if(access != 0 && watching.load(std::memory_order_relaxed)) {
+        for(uint16_t i = 0; i < count; ++i) {
+            const uint16_t address = (I + i) & 0xFFF;
+            if(flags[address].load(std::memory_order_relaxed) & access)
+                return stop({ access == ReadWatch ? Reason::ReadWatch : Reason::WriteWatch, pc, address });
+        }
+    }
+    return execute();
+}
+
+bool Debugger::stop(const Hit& hit) {
+    mutex.lock();
+    lastHit = hit;
+    mutex.unlock();
+    emit stopped();
+    return true;
+}
+
+bool Debugger::evaluate(const Condition& condition) {
+    uint16_t value = 0;
+    switch(condition.operand) {
+        case RegisterI:     value = chip8.getI(); break;
+        case StackPointer:  value = chip8.getSp(); break;
+        case DelayTimer:    value = chip8.getDelayTimer(); break;
+        case SoundTimer:    value = chip8.getSoundTimer(); break;
+        default:            value = chip8.getV(condition.operand & 0xF); break;
+    }
+
+    switch(condition.compare) {
+        case Compare::Equal:        return value == condition.value;
+        case Compare::NotEqual:     return value != condition.value;
+        case Compare::Less:         return value < condition.value;
+        case Compare::LessEqual:    return value <= condition.value;
+        case Compare::Greater:      return value > condition.value;
+        case Compare::GreaterEqual: return value >= condition.value;
+    }
+    return false;
+}
+
+void Debugger::updateArmed() {
+    bool anyFlag = false;
+    bool anyWatch = false;
+    for(const auto& flag : flags) {
+        const uint8_t value = flag.load(std::memory_order_relaxed);
+        anyFlag |= value != 0;
+        anyWatch |= (value & (ReadWatch | WriteWatch)) != 0;
+    }
+
+    QMutexLocker locker(&mutex);
+    hasGlobalConditions = std::any_of(conditions.begin(), conditions.end(),
+        [](const Condition& condition) { return condition.address == anyAddress; });
+    watching = anyWatch;
+    armed = anyFlag || !conditions.empty() || tracking || stepping;
+    // only check() consumes it, and it is not called while unarmed
+    if(!armed)
+        skipNext = false;
+}
+
+std::string Debugger::command(const std::string& line) {
+    std::string lowered = line;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+    std::istringstream in(lowered);
+    std::string name;
+    std::string argument;
+    in >> name >> argument;
+
+    if(name.empty())
+        return "";
+    if(name == "help" || name == "h")
+        return helpText;
+
+    if(name == "break" || name == "b") {
+        uint16_t address = anyAddress;
+        if(argument != "*" && !parseNumber(argument, address, Memory::memorySize - 1))
+            return "Usage: break ADDR|* [REG OP VALUE]";
+
+        std::string operand, compare, value;
+        if(!(in >> operand)) {
+            if(address == anyAddress)
+                return "break * needs a condition";
+            setBreakpoint(address, true);
+            return format("Breakpoint at 0x%03X", address);
+        }
+
+        Condition condition { address, 0, Compare::Equal, 0 };
+        in >> compare >> value;
+        if(!parseOperand(operand, condition.operand) || !parseCompare(compare, condition.compare)
+            || !parseNumber(value, condition.value, UINT16_MAX))
+            return "Usage: break ADDR|* REG OP VALUE, e.g. break 2a4 v3 >= 10";
+        addCondition(condition);
+        return "Condition " + formatCondition(condition);
+    }
+
+    if(name == "watch" || name == "w" || name == "unwatch") {
+        uint16_t begin, end;
+        std::string mode;
+        if(!(in >> mode))
+            mode = "rw";
+        if(!parseRange(argument, begin, end) || (mode != "r" && mode != "w" && mode != "rw"))
+            return "Usage: watch ADDR[-END] [r|w|rw]";
+
+        const uint8_t watchFlags = (mode.find('r') != std::string::npos ? ReadWatch : 0)
+            | (mode.find('w') != std::string::npos ? WriteWatch : 0);
+        const bool enabled = name != "unwatch";
+        setWatch(begin, end, enabled ? watchFlags : ReadWatch | WriteWatch, enabled);
+        return format("%s 0x%03X-0x%03X", enabled ? "Watching" : "Stopped watching", begin, end);
+    }
+
+    if(name == "delete" || name == "d") {
+        uint16_t address = anyAddress;
+        if(argument != "*" && !parseNumber(argument, address, Memory::memorySize - 1))
+            return "Usage: delete ADDR|*";
+        clearAddress(address);
+        return "Deleted";
+    }
+
+    if(name == "clear") {
+        clearAll();
+        return "Cleared";
+    }
+
+    if(name == "list" || name == "l")
+        return list();
+
+    if(name == "continue" || name == "c") {
+        resume();
+        return "Running";
+    }
+
+    if(name == "step" || name == "s") {
+        step();
+        return "";
+    }
+
+    if(name == "pause" || name == "p") {
+        chip8.pause();
+        return "Paused";
+    }
+
+    if(name == "track") {
+        if(argument != "on" && argument != "off")
+            return "Usage: track on|off";
+        setTracking(argument == "on");
+        return argument == "on" ? "Counting memory accesses" : "Stopped counting memory accesses";
+    }
+
+    if(name == "accesses" || name == "a") {
+        uint16_t begin, end;
+        if(!parseRange(argument, begin, end))
+            return "Usage: accesses ADDR[-END]";
+
+        std::string reply;
+        for(uint32_t address = begin; address <= end; ++address) {
+            if(readCount[address] == 0 && writeCount[address] == 0)
+                continue;
+            reply += format("0x%03X  reads %u  writes %u\n", address,
+                unsigned(readCount[address]), unsigned(writeCount[address]));
+        }
+        return reply.empty() ? "No accesses" : reply;
+    }
+
+    return "Unknown command " + name + ", see help";
+}
+
+std::string Debugger::list() {
+    std::string reply;
+
+    for(uint16_t address = 0; address < Memory::memorySize; ++address) {
+        if(flags[address] & Breakpoint)
+            reply += format("Breakpoint 0x%03X\n", address);
+    }
+
+    // watched ranges with the same mode are listed as one
+    for(uint16_t address = 0; address < Memory::memorySize;) {
+        const uint8_t watch = flags[address] & (ReadWatch | WriteWatch);
+        uint16_t end = address;
+        while(end + 1 < Memory::memorySize && (flags[end + 1] & (ReadWatch | WriteWatch)) == watch)
+            ++end;
+        if(watch != 0) {
+            const char* mode = watch == (ReadWatch | WriteWatch) ? "rw" : watch == ReadWatch ? "r" : "w";
+            reply += format("Watch 0x%03X-0x%03X %s\n", address, end, mode);
+        }
+        address = end + 1;
+    }
+
+    mutex.lock();
+    for(const Condition& condition : conditions)
+        reply += "Condition " + formatCondition(condition) + "\n";
+    mutex.unlock();
+
+    if(tracking)
+        reply += "Counting memory accesses\n";
+    return reply.empty() ? "Nothing set" : reply;
+}
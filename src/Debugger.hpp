@@ -0,0 +1,102 @@
+#ifndef DEBUGGER_HPP
+#define DEBUGGER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <QMutex>
+#include <QObject>
+
+#include "Memory.hpp"
+
+class Chip8;
+
+/* Breakpoints, conditional breakpoints on registers and read/write watchpoints for one Chip8.
+     * + every address has a flag byte, so checking an instruction is one lookup for its pc and one per byte it accesses
+     * + Chip8 only calls check() while something is armed, otherwise it runs its uninstrumented loop at full speed
+     * + a hit pauses the emulator before the instruction executes and emits stopped()*/
+
+class Debugger : public QObject {
+    Q_OBJECT
+public:
+    enum Flag : uint8_t {
+        Breakpoint  = 1 << 0,
+        ReadWatch   = 1 << 1,
+        WriteWatch  = 1 << 2,
+        Conditional = 1 << 3,   // conditions are registered for this address
+    };
+
+    // V0-VF are 0x0-0xF
+    enum Operand : uint8_t { RegisterI = 16, StackPointer, DelayTimer, SoundTimer };
+    enum class Compare : uint8_t { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+    enum class Reason : uint8_t { None, Breakpoint, Condition, ReadWatch, WriteWatch, Step };
+
+    struct Condition {
+        uint16_t address;   // anyAddress = checked before every instruction
+        uint8_t operand;
+        Compare compare;
+        uint16_t value;
+    };
+
+    struct Hit {
+        Reason reason;
+        uint16_t pc;
+        uint16_t address;   // accessed address for watchpoints, pc otherwise
+    };
+
+    static constexpr uint16_t anyAddress = 0xFFFF;
+
+    Debugger(Chip8& target);
+    ~Debugger() = default;
+
+    void setBreakpoint(const uint16_t address, const bool enabled);
+    void setWatch(const uint16_t begin, const uint16_t end, const uint8_t watchFlags, const bool enabled); // end inclusive
+    void addCondition(const Condition& condition);
+    void clearAddress(const uint16_t address);  // breakpoint, watches and conditions at address
+    void clearAll();
+    void setTracking(const bool enabled);       // count reads and writes per address
+    inline uint32_t getReadCount(const uint16_t address) { return readCount[address & 0xFFF]; }
+    inline uint32_t getWriteCount(const uint16_t address) { return writeCount[address & 0xFFF]; }
+
+    void resume();  // continues past the instruction it stopped at
+    void step();    // executes one instruction, then stops again
+    Hit getLastHit();
+    inline bool hasBreakpoint(const uint16_t address) { return flags[address & 0xFFF] & Breakpoint; }
+    inline bool isArmed() { return armed.load(std::memory_order_relaxed); }
+
+    // The debugger pane's command line, returns the reply
+    std::string command(const std::string& line);
+
+    // Called by the emulation thread before executing opcode, true = stop
+    bool check(const uint16_t opcode);
+
+signals:
+    void stopped();
+
+private:
+    bool stop(const Hit& hit);
+    bool evaluate(const Condition& condition);
+    void updateArmed();
+    std::string list();
+
+    Chip8& chip8;
+    std::array<std::atomic<uint8_t>, Memory::memorySize> flags;
+    std::array<std::atomic<uint32_t>, Memory::memorySize> readCount;
+    std::array<std::atomic<uint32_t>, Memory::memorySize> writeCount;
+
+    QMutex mutex;   // guards conditions and lastHit
+    std::vector<Condition> conditions;
+    Hit lastHit;
+
+    std::atomic<bool> armed;
+    std::atomic<bool> watching;
+    std::atomic<bool> tracking;
+    std::atomic<bool> stepping;
+    std::atomic<bool> skipNext;
+    std::atomic<bool> hasGlobalConditions;
+};
+
+#endif // DEBUGGER_HPP
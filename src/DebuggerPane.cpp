@@ -0,0 +1,100 @@
+#include "DebuggerPane.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include <QFontDatabase>
+#include <QVBoxLayout>
+
+#include "Disassembler.hpp"
+#include "StringFormat.hpp"
+
+DebuggerPane::DebuggerPane(QWidget *parent) :
+    QWidget(parent),
+    stateView(new QPlainTextEdit(this)),
+    log(new QPlainTextEdit(this)),
+    commandLine(new QLineEdit(this)),
+    chip8(nullptr),
+    debugger(nullptr) {
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    stateView->setReadOnly(true);
+    log->setReadOnly(true);
+    commandLine->setPlaceholderText("help");
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(stateView, 3);
+    layout->addWidget(log, 1);
+    layout->addWidget(commandLine);
+
+    connect(commandLine, SIGNAL(returnPressed()), this, SLOT(executeCommand()));
+}
+
+void DebuggerPane::setTarget(Chip8* targetChip8, Debugger* targetDebugger) {
+    chip8 = targetChip8;
+    debugger = targetDebugger;
+    // stopped() comes from the emulation thread, the queued connection refreshes on the GUI thread
+    connect(debugger, SIGNAL(stopped()), this, SLOT(refresh()));
+    refresh();
+}
+
+void DebuggerPane::executeCommand() {
+    if(debugger == nullptr)
+        return;
+
+    const QString line = commandLine->text();
+    commandLine->clear();
+    log->appendPlainText("> " + line);
+    const std::string reply = debugger->command(line.toStdString());
+    if(!reply.empty())
+        log->appendPlainText(QString::fromStdString(reply));
+    refresh();
+}
+
+void DebuggerPane::refresh() {
+    if(chip8 == nullptr || debugger == nullptr)
+        return;
+
+    const Debugger::Hit hit = debugger->getLastHit();
+    std::string text;
+    if(hit.reason != Debugger::Reason::None)
+        text = describeHit(hit);
+    else
+        text = !chip8->isAlive() ? "Stopped" : chip8->isPaused() ? "Paused" : "Running";
+    text += "\n\n";
+
+    // the emulation thread keeps writing the registers, read a copy taken between two frames
+    chip8->snapshot(state);
+    const uint16_t pc = state.pc;
+    text += format("PC %03X  I %03X  SP %X  DT %02X  ST %02X\n",
+        pc, state.I, state.sp, state.delayTimer, state.soundTimer);
+    for(uint8_t r = 0; r < 16; ++r)
+        text += format(r % 8 == 7 ? "V%X %02X\n" : "V%X %02X  ", r, state.V[r]);
+
+    text += "Stack";
+    for(uint8_t level = 0; level < state.sp && level < 16; ++level)
+        text += format(" %03X", state.stack[level]);
+    text += "\n\n";
+
+    // > marks pc, * breakpoints
+    const uint16_t first = pc >= 2 * disassemblyLines ? pc - 2 * disassemblyLines : pc % 2;
+    for(uint32_t address = first; address <= pc + 2u * disassemblyLines && address + 1 < Memory::memorySize; address += 2) {
+        const uint16_t opcode = state.memory[address] << 8 | state.memory[address + 1];
+        text += address == pc ? ">" : " ";
+        text += debugger->hasBreakpoint(address) ? "* " : "  ";
+        text += Disassembler::formatLine(address, opcode) + "\n";
+    }
+
+    stateView->setPlainText(QString::fromStdString(text));
+}
+
+std::string DebuggerPane::describeHit(const Debugger::Hit& hit) {
+    switch(hit.reason) {
+        case Debugger::Reason::Breakpoint:  return format("Breakpoint at %03X", hit.pc);
+        case Debugger::Reason::Condition:   return format("Condition met at %03X", hit.pc);
+        case Debugger::Reason::ReadWatch:   return format("%03X reads %03X", hit.pc, hit.address);
+        case Debugger::Reason::WriteWatch:  return format("%03X writes %03X", hit.pc, hit.address);
+        case Debugger::Reason::Step:        return format("Stepped to %03X", hit.pc);
+        case Debugger::Reason::None:        break;
+    }
+    return "";
+}
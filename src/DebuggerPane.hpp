@@ -0,0 +1,38 @@
+#ifndef DEBUGGER_PANE_HPP
+#define DEBUGGER_PANE_HPP
+
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QWidget>
+
+#include "Chip8.hpp"
+#include "Debugger.hpp"
+
+// Registers, stack and disassembly around pc, plus a command line for the debugger (type help)
+class DebuggerPane : public QWidget {
+    Q_OBJECT
+public:
+    DebuggerPane(QWidget* parent = nullptr);
+
+    void setTarget(Chip8* targetChip8, Debugger* targetDebugger);
+
+public slots:
+    void refresh();
+
+private slots:
+    void executeCommand();
+
+private:
+    constexpr static uint16_t disassemblyLines = 8; // instructions shown before and after pc
+
+    std::string describeHit(const Debugger::Hit& hit);
+
+    QPlainTextEdit* stateView;
+    QPlainTextEdit* log;
+    QLineEdit* commandLine;
+    Chip8* chip8;
+    Debugger* debugger;
+    Chip8::State state;     // what refresh() shows
+};
+
+#endif // DEBUGGER_PANE_HPP
@@ -0,0 +1,14 @@
+#ifndef DISASSEMBLER_HPP
+#define DISASSEMBLER_HPP
+
+#include <cstdint>
+#include <string>
+
+// Cowgod's CHIP-8 mnemonics, e.g. 0x6A02 -> "LD VA, 0x02"
+struct Disassembler {
+    static std::string disassemble(const uint16_t opcode);
+    // "0x200  6A02  LD VA, 0x02"
+    static std::string formatLine(const uint16_t address, const uint16_t opcode);
+};
+
+#endif // DISASSEMBLER_HPP
@@ -4,19 +4,23 @@
 
 #include <QPainter>
 
-#include "Chip8.hpp"
-
 EmulationScreenWidget::EmulationScreenWidget(QWidget *parent) :
-    QWidget(parent) {
+    QWidget(parent),
+    screen(nullptr) {
     repaintTimer.setInterval(timerInterval_ms);
     connect(&repaintTimer, SIGNAL(timeout()), this, SLOT(forceRepaint()));
     repaintTimer.start();
+    // the upscaler finishes between two timer ticks, show its image right away
+    connect(&upscaler, SIGNAL(imageReady()), this, SLOT(update()));
 }
 
 // Draw pixels on the screen 
 void EmulationScreenWidget::paintEvent(QPaintEvent * event) {
     Q_UNUSED(event)
 
+    if(screen == nullptr)
+        return;
+
     QPainter painter(this);
     painter.setPen(Qt::blue);
 
@@ -28,10 +32,18 @@ void EmulationScreenWidget::paintEvent(QPaintEvent * event) {
 
     uint32_t xOffset = width() % xRes / 2;
     uint32_t yOffset = height() % yRes / 2;
+
+    if(upscaler.getFilter() != Upscaler::Filter::None) {
+        // filtered off the GUI thread, the image only needs to be blitted
+        const QImage image = upscaler.getImage();
+        if(!image.isNull())
+            painter.drawImage(QRect(xOffset, yOffset, pixelWidth * xRes, pixelHeight * yRes), image);
+        return;
+    }
     
     for(uint16_t y = 0; y < yRes; ++y) {
             for(uint16_t x = 0; x < xRes; ++x) {
-                if(!Screen::getPixel(x, y))
+                if(!screen->getPixel(x, y))
                     // TODO: Render pixel as a class (derived from rectangle)?
                     painter.fillRect(pixelWidth * x + xOffset, pixelHeight * y + yOffset, pixelWidth, pixelHeight, Qt::black);
             }
@@ -39,6 +51,7 @@ void EmulationScreenWidget::paintEvent(QPaintEvent * event) {
 }
 
 void EmulationScreenWidget::forceRepaint() {
-    Chip8::updateTimers();
+    if(screen != nullptr && upscaler.getFilter() != Upscaler::Filter::None)
+        upscaler.submit(screen->getFrame());
     repaint();
 }
@@ -5,12 +5,16 @@
 #include <QTimer>
 
 #include "Screen.hpp"
+#include "Upscaler.hpp"
 
-class EmulationScreenWidget : public QWidget, public Screen {
+class EmulationScreenWidget : public QWidget {
     Q_OBJECT
 public:
     EmulationScreenWidget(QWidget *parent = nullptr);
 
+    inline void setScreen(Screen* newScreen) { screen = newScreen; }
+    inline void setFilter(const Upscaler::Filter filter) { upscaler.setFilter(filter); }
+
 private slots:
     void forceRepaint();
 
@@ -21,6 +25,9 @@ protected:
 
 private:
     constexpr static int timerInterval_ms = 17;
+
+    Screen* screen;
+    Upscaler upscaler;
 };
 
 #endif // !EMULATION_SCREEN_WIDGET_HPP
@@ -0,0 +1,93 @@
+#include "FramePlayer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#include <QElapsedTimer>
+
+#include "Timing.hpp"
+
+FramePlayer::FramePlayer(Screen& targetScreen) :
+    screen(targetScreen),
+    frameCount(0),
+    playing(false) {
+    payload.resize(2 * FrameStream::frameBytes);
+}
+
+FramePlayer::~FramePlayer() {
+    stop();
+}
+
+bool FramePlayer::open(const std::string& fileName) {
+    stop();
+    file.close();
+    file.open(fileName, std::ios::binary);
+    if(!file.is_open()) {
+        std::cout << "Could not open " << fileName << " for playback!" << std::endl;
+        return false;
+    }
+
+    uint8_t header[FrameStream::headerSize];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if(!file
+        || !std::equal(FrameStream::magic.begin(), FrameStream::magic.end(), header)
+        || header[4] != FrameStream::version
+        || header[5] != Screen::xRes_
+        || header[6] != Screen::yRes_) {
+        std::cout << fileName << " is not a frame stream!" << std::endl;
+        file.close();
+        return false;
+    }
+
+    currentFrame.fill(0);
+    frameCount = 0;
+    // set before start(), so a stop() right after start() is not undone by run()
+    playing = true;
+    return true;
+}
+
+bool FramePlayer::nextFrame(Screen::Frame& frame) {
+    uint8_t sizeBytes[2];
+    if(!file.read(reinterpret_cast<char*>(sizeBytes), sizeof(sizeBytes)))
+        return false;
+
+    const uint16_t size = sizeBytes[0] | sizeBytes[1] << 8;
+    if(size > payload.size() || !file.read(reinterpret_cast<char*>(payload.data()), size))
+        return false;
+    if(!FrameStream::decode(payload.data(), size, currentFrame))
+        return false;
+
+    frameCount++;
+    frame = currentFrame;
+    return true;
+}
+
+void FramePlayer::stop() {
+    playing = false;
+    wait();
+}
+
+void FramePlayer::run() {
+    if(!file.is_open())
+        return;
+
+    QElapsedTimer timer;
+    uint64_t accuTime = 0;
+    Screen::Frame frame;
+
+    timer.start();
+    while(playing) {
+        accuTime += timer.nsecsElapsed();
+        timer.restart();
+
+        for(;accuTime >= Timing::frameDuration_ns; accuTime -= Timing::frameDuration_ns) {
+            if(!nextFrame(frame)) {
+                playing = false;
+                break;
+            }
+            screen.setFrame(frame);
+        }
+        QThread::msleep(1);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef FRAME_PLAYER_HPP
+#define FRAME_PLAYER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <QThread>
+
+#include "FrameStream.hpp"
+#include "Screen.hpp"
+
+// Decodes a frame stream file and plays it back onto the screen at 60 frames per second
+class FramePlayer : public QThread {
+    Q_OBJECT
+public:
+    FramePlayer(Screen& targetScreen);
+    ~FramePlayer();
+
+    bool open(const std::string& fileName); // arms playback, start() plays until stop() or the end of the file
+    bool nextFrame(Screen::Frame& frame);
+    void stop();
+    inline uint64_t getFrameCount() { return frameCount; }
+
+    void run() override;
+
+private:
+    Screen& screen;
+    std::ifstream file;
+    Screen::Frame currentFrame;
+    std::vector<uint8_t> payload;
+    uint64_t frameCount;
+    std::atomic<bool> playing;
+};
+
+#endif // FRAME_PLAYER_HPP
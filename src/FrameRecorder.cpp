@@ -0,0 +1,86 @@
+#include "FrameRecorder.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+FrameRecorder::FrameRecorder() :
+    recording(false),
+    droppedFrames(0) {
+    payload.reserve(2 * FrameStream::frameBytes);
+}
+
+FrameRecorder::~FrameRecorder() {
+    close();
+}
+
+bool FrameRecorder::open(const std::string& fileName) {
+    close();
+
+    file.open(fileName, std::ios::binary | std::ios::trunc);
+    if(!file.is_open()) {
+        std::cout << "Could not open " << fileName << " for recording!" << std::endl;
+        return false;
+    }
+
+    const uint8_t header[FrameStream::headerSize] {
+        static_cast<uint8_t>(FrameStream::magic[0]),
+        static_cast<uint8_t>(FrameStream::magic[1]),
+        static_cast<uint8_t>(FrameStream::magic[2]),
+        static_cast<uint8_t>(FrameStream::magic[3]),
+        FrameStream::version,
+        Screen::xRes_,
+        Screen::yRes_,
+        0
+    };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    // the recorder thread is stopped, so nothing pops concurrently. Frames left from a producer that was still
+    // attached during the last close() must not start this recording.
+    Screen::Frame stale;
+    while(queue.pop(stale));
+
+    previousFrame.fill(0);
+    droppedFrames = 0;
+    recording = true;
+    start();
+    return true;
+}
+
+void FrameRecorder::close() {
+    if(!recording)
+        return;
+    // run() drains the queue before returning
+    recording = false;
+    wait();
+    file.close();
+}
+
+void FrameRecorder::pushFrame(const Screen::Frame& frame) {
+    if(!recording)
+        return;
+    if(!queue.push(frame))
+        droppedFrames++;
+}
+
+void FrameRecorder::run() {
+    Screen::Frame frame;
+
+    while(recording || !queue.empty()) {
+        if(!queue.pop(frame)) {
+            QThread::msleep(1);
+            continue;
+        }
+        writeFrame(frame);
+    }
+    file.flush();
+}
+
+void FrameRecorder::writeFrame(const Screen::Frame& frame) {
+    FrameStream::encode(previousFrame, frame, payload);
+    previousFrame = frame;
+
+    const uint16_t size = payload.size();
+    const uint8_t sizeBytes[2] { static_cast<uint8_t>(size & 0xFF), static_cast<uint8_t>(size >> 8) };
+    file.write(reinterpret_cast<const char*>(sizeBytes), sizeof(sizeBytes));
+    file.write(reinterpret_cast<const char*>(payload.data()), size);
+}
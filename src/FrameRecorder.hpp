@@ -0,0 +1,45 @@
+#ifndef FRAME_RECORDER_HPP
+#define FRAME_RECORDER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <QThread>
+
+#include "FrameStream.hpp"
+#include "Screen.hpp"
+#include "SpscQueue.hpp"
+
+// Records every emulated frame into a frame stream file (see FrameStream.hpp) on its own thread
+class FrameRecorder : public QThread {
+    Q_OBJECT
+public:
+    FrameRecorder();
+    ~FrameRecorder();
+
+    bool open(const std::string& fileName);
+    void close();   // detach it from the Chip8 first (Chip8::setRecorder(nullptr)), it is the only producer
+    void pushFrame(const Screen::Frame& frame); // called from the emulation thread, never blocks
+    inline bool isRecording() { return recording; }
+    inline uint64_t getDroppedFrames() { return droppedFrames; }
+
+    void run() override;
+
+private:
+    static constexpr size_t queueCapacity = 256; // ~4 seconds of frames
+
+    void writeFrame(const Screen::Frame& frame);
+
+    SpscQueue<Screen::Frame, queueCapacity> queue;
+    std::atomic<bool> recording;
+    std::atomic<uint64_t> droppedFrames;
+
+    std::ofstream file;
+    Screen::Frame previousFrame;
+    std::vector<uint8_t> payload;
+};
+
+#endif // FRAME_RECORDER_HPP
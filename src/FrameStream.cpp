@@ -0,0 +1,47 @@
+#include "FrameStream.hpp"
+
+#include <cstdint>
+
+void FrameStream::encode(const Screen::Frame& previous, const Screen::Frame& current, std::vector<uint8_t>& payload) {
+    payload.clear();
+
+    uint8_t runByte = 0;
+    uint8_t runLength = 0;
+
+    for(uint16_t y = 0; y < Screen::yRes_; ++y) {
+        const uint64_t delta = previous[y] ^ current[y];
+
+        for(uint8_t i = 0; i < sizeof(uint64_t); ++i) {
+            const uint8_t byte = delta >> (8 * i);
+
+            if(runLength > 0 && (byte != runByte || runLength == 255)) {
+                payload.push_back(runLength);
+                payload.push_back(runByte);
+                runLength = 0;
+            }
+            runByte = byte;
+            ++runLength;
+        }
+    }
+    payload.push_back(runLength);
+    payload.push_back(runByte);
+}
+
+bool FrameStream::decode(const uint8_t* payload, const uint16_t size, Screen::Frame& frame) {
+    if(size % 2 != 0)
+        return false;
+
+    uint16_t byteIdx = 0;
+    for(uint16_t i = 0; i < size; i += 2) {
+        const uint8_t runLength = payload[i];
+        const uint64_t runByte = payload[i+1];
+
+        if(byteIdx + runLength > frameBytes)
+            return false;
+
+        for(uint8_t j = 0; j < runLength; ++j, ++byteIdx)
+            frame[byteIdx / sizeof(uint64_t)] ^= runByte << (8 * (byteIdx % sizeof(uint64_t)));
+    }
+
+    return byteIdx == frameBytes;
+}
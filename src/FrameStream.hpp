@@ -0,0 +1,27 @@
+#ifndef FRAME_STREAM_HPP
+#define FRAME_STREAM_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Screen.hpp"
+
+/* Frame stream file format (.c8fs):
+     * + header: "C8FS", version, xRes, yRes, reserved (8 bytes)
+     * + every emulated frame: uint16 little-endian payload size, followed by the payload
+     * + payload: frame XOR previous frame (first frame is XORed against a blank screen),
+     *   serialized row by row in little-endian and run-length encoded as (count, byte) pairs*/
+
+struct FrameStream {
+    static constexpr std::array<char, 4> magic { 'C', '8', 'F', 'S' };
+    static constexpr uint8_t version = 1;
+    static constexpr uint8_t headerSize = 8;
+    static constexpr uint16_t frameBytes = Screen::yRes_ * sizeof(uint64_t);
+
+    static void encode(const Screen::Frame& previous, const Screen::Frame& current, std::vector<uint8_t>& payload);
+    // applies the payload to frame in place, frame has to hold the previous frame
+    static bool decode(const uint8_t* payload, const uint16_t size, Screen::Frame& frame);
+};
+
+#endif // FRAME_STREAM_HPP
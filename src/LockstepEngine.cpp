@@ -0,0 +1,611 @@
+#include "LockstepEngine.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// GCC/Clang vector extensions, lowered to SSE2 by default and to AVX2 with CHIP8_ENABLE_AVX2
+using u8x32  = uint8_t  __attribute__((vector_size(32)));
+using s8x32  = int8_t   __attribute__((vector_size(32)));
+using u16x32 = uint16_t __attribute__((vector_size(64)));
+using s16x32 = int16_t  __attribute__((vector_size(64)));
+using u32x32 = uint32_t __attribute__((vector_size(128)));
+using s32x32 = int32_t  __attribute__((vector_size(128)));
+
+static_assert(sizeof(u8x32) == LockstepEngine::maxLanes);
+
+template<typename Vec, typename T>
+inline Vec load(const T* data) {
+    Vec vec;
+    std::memcpy(&vec, data, sizeof(vec));
+    return vec;
+}
+
+template<typename T, typename Vec>
+inline void store(T* data, const Vec& vec) {
+    std::memcpy(data, &vec, sizeof(vec));
+}
+
+inline u8x32 select(const s8x32 mask, const u8x32 a, const u8x32 b) {
+    return (a & (u8x32)mask) | (b & ~(u8x32)mask);
+}
+
+inline u16x32 select(const s16x32 mask, const u16x32 a, const u16x32 b) {
+    return (a & (u16x32)mask) | (b & ~(u16x32)mask);
+}
+
+// lane i of the result is all ones when bit i of group is set
+inline s8x32 laneMask(const uint32_t group) {
+    static const u32x32 bits = [] {
+        u32x32 laneBits;
+        for(uint32_t lane = 0; lane < LockstepEngine::maxLanes; ++lane)
+            laneBits[lane] = 1u << lane;
+        return laneBits;
+    }();
+    const s32x32 mask = (bits & group) != 0;
+    return __builtin_convertvector(mask, s8x32);
+}
+
+// bit i of the result is set when lane i of mask is, the inverse of laneMask
+inline uint32_t laneBits(const s8x32 mask) {
+#if defined(__AVX2__)
+    return _mm256_movemask_epi8((__m256i)mask);
+#elif defined(__SSE2__)
+    __m128i half[2];
+    std::memcpy(half, &mask, sizeof(half));
+    return uint32_t(_mm_movemask_epi8(half[0])) | uint32_t(_mm_movemask_epi8(half[1])) << 16;
+#else
+    uint32_t bits = 0;
+    for(uint32_t lane = 0; lane < LockstepEngine::maxLanes; ++lane)
+        bits |= uint32_t(mask[lane] != 0) << lane;
+    return bits;
+#endif
+}
+
+// Opcodes executeGroup() runs as vector operations, the rest goes lane by lane
+inline bool isVectorOpcode(const uint16_t op) {
+    switch(op & 0xF000) {
+        case 0x1000: case 0x3000: case 0x4000: case 0x5000: case 0x6000:
+        case 0x7000: case 0x8000: case 0x9000: case 0xA000:
+            return true;
+        case 0xF000:
+            switch(op & 0x00FF) {
+                case 0x0007: case 0x0015: case 0x0018: case 0x001E:
+                    return true;
+            }
+            return false;
+    }
+    return false;
+}
+
+}
+
+LockstepEngine::LockstepEngine(const uint32_t lanes) :
+    laneCount(std::clamp<uint32_t>(lanes, 1, maxLanes)),
+    crashed(0),
+    clockScale(1.0),
+    displayWait(false),
+    memory(Memory::memorySize) {
+    bootImage.fill(0);
+    std::copy(Memory::fontset.begin(), Memory::fontset.end(), bootImage.begin());
+    for(uint32_t lane = 0; lane < maxLanes; ++lane)
+        rngSeed[lane] = lane + 1;
+    reset();
+}
+
+bool LockstepEngine::loadRom(const uint8_t* rom, const size_t size) {
+    if(size > Memory::memorySize - Memory::programBegin)
+        return false;
+
+    std::fill(bootImage.begin() + Memory::fontsetSize, bootImage.end(), 0);
+    std::copy_n(rom, size, bootImage.begin() + Memory::programBegin);
+    reset();
+    return true;
+}
+
+void LockstepEngine::seed(const uint32_t lane, const uint32_t seed) {
+    // xorshift32 gets stuck on 0
+    rngSeed[lane] = seed != 0 ? seed : 1;
+    rngState[lane] = rngSeed[lane];
+}
+
+void LockstepEngine::reset() {
+    // padding lanes are reset too, they are computed along but never read
+    for(uint32_t lane = 0; lane < maxLanes; ++lane)
+        resetLane(lane);
+}
+
+void LockstepEngine::resetLane(const uint32_t lane) {
+    for(uint8_t r = 0; r < 16; ++r) {
+        V[r][lane] = 0;
+        stack[r][lane] = 0;
+    }
+    pc[lane] = Memory::programBegin;
+    I[lane] = 0;
+    sp[lane] = 0;
+    delayTimer[lane] = 0;
+    soundTimer[lane] = 0;
+    keypad[lane] = 0;
+    opcode[lane] = 0;
+    rngState[lane] = rngSeed[lane];
+    cycleBalance[lane] = 0;
+    crashed &= ~(1u << lane);
+    frames[lane].fill(0);
+    for(uint16_t address = 0; address < Memory::memorySize; ++address)
+        memory[address][lane] = bootImage[address];
+}
+
+void LockstepEngine::saveLane(const uint32_t lane, LaneState& state) {
+    state.pc = pc[lane];
+    state.I = I[lane];
+    state.sp = sp[lane];
+    for(uint8_t r = 0; r < 16; ++r) {
+        state.V[r] = V[r][lane];
+        state.stack[r] = stack[r][lane];
+    }
+    state.delayTimer = delayTimer[lane];
+    state.soundTimer = soundTimer[lane];
+    state.rngState = rngState[lane];
+    state.cycleBalance = cycleBalance[lane];
+    state.crashed = isCrashed(lane);
+    for(uint16_t address = 0; address < Memory::memorySize; ++address)
+        state.memory[address] = memory[address][lane];
+    state.frame = frames[lane];
+}
+
+void LockstepEngine::loadLane(const uint32_t lane, const LaneState& state) {
+    pc[lane] = state.pc;
+    I[lane] = state.I;
+    sp[lane] = state.sp;
+    for(uint8_t r = 0; r < 16; ++r) {
+        V[r][lane] = state.V[r];
+        stack[r][lane] = state.stack[r];
+    }
+    delayTimer[lane] = state.delayTimer;
+    soundTimer[lane] = state.soundTimer;
+    rngState[lane] = state.rngState;
+    cycleBalance[lane] = static_cast<int32_t>(state.cycleBalance);
+    if(state.crashed)
+        crashed |= 1u << lane;
+    else
+        crashed &= ~(1u << lane);
+    for(uint16_t address = 0; address < Memory::memorySize; ++address)
+        memory[address][lane] = state.memory[address];
+    frames[lane] = state.frame;
+}
+
+void LockstepEngine::stepFrame(const uint16_t* keypads) {
+    const int32_t budget = static_cast<int32_t>(Timing::frameBudget * clockScale);
+    const uint32_t lanes = laneCount == 32 ? UINT32_MAX : (1u << laneCount) - 1;
+
+    for(uint32_t lane = 0; lane < laneCount; ++lane)
+        keypad[lane] = keypads != nullptr ? keypads[lane] : 0;
+
+    s32x32 balance = load<s32x32>(cycleBalance) + budget;
+    store(cycleBalance, balance);
+    uint32_t running = laneBits(__builtin_convertvector(balance > 0, s8x32)) & lanes & ~crashed;
+    uint32_t firstInFrame = running;
+
+    // Charges cost to the lanes of group, returns the lanes which ran out of cycles
+    auto charge = [this](const uint32_t group, const int32_t cost) {
+        const s32x32 mask = __builtin_convertvector(laneMask(group), s32x32);
+        const s32x32 balance = load<s32x32>(cycleBalance) - (mask & cost);
+        store(cycleBalance, balance);
+        return laneBits(__builtin_convertvector(balance <= 0, s8x32)) & group;
+    };
+
+    while(running != 0) {
+        uint16_t leadOpcode;
+        const uint32_t uniform = fetch(running, leadOpcode);
+        uint32_t executing = running;
+
+        // Display wait: DXYN has to start a frame, see Chip8::emulateFrame
+        if(displayWait) {
+            uint32_t waiting = (leadOpcode & 0xF000) == 0xD000 ? uniform : 0;
+            for(uint32_t bits = running & ~uniform; bits != 0; bits &= bits - 1) {
+                const uint32_t lane = std::countr_zero(bits);
+                if((opcode[lane] & 0xF000) == 0xD000)
+                    waiting |= 1u << lane;
+            }
+            waiting &= ~firstInFrame;
+            running &= ~waiting;
+            executing &= ~waiting;
+        }
+        firstInFrame &= ~executing;
+
+        // Lanes of the same ROM mostly agree on the pc, then this is the only group
+        if(const uint32_t group = uniform & executing; group != 0) {
+            running &= ~charge(group, Timing::instructionCost(leadOpcode));
+            executeGroup(leadOpcode, group);
+        }
+
+        for(uint32_t remaining = executing & ~uniform; remaining != 0;) {
+            const uint16_t op = opcode[std::countr_zero(remaining)];
+            const s16x32 same = load<u16x32>(opcode) == op;
+            const uint32_t group = laneBits(__builtin_convertvector(same, s8x32)) & remaining;
+            remaining &= ~group;
+            running &= ~charge(group, Timing::instructionCost(op));
+            executeGroup(op, group);
+        }
+        running &= ~crashed;
+    }
+
+    // Unused cycles are spent spinning, only the debt carries over
+    const s32x32 zero = {};
+    balance = load<s32x32>(cycleBalance);
+    store(cycleBalance, balance < zero ? balance : zero);
+
+    const s8x32 live = laneMask(lanes & ~crashed);
+    u8x32 dt = load<u8x32>(delayTimer);
+    u8x32 st = load<u8x32>(soundTimer);
+    dt = select(live & (dt > 0), dt - 1, dt);
+    st = select(live & (st > 0), st - 1, st);
+    store(delayTimer, dt);
+    store(soundTimer, st);
+}
+
+// Fetches the opcode of every running lane, returns the lanes whose opcode equals leadOpcode
+// because they share its pc and the bytes at it. opcode[] is only filled for the other lanes.
+uint32_t LockstepEngine::fetch(const uint32_t running, uint16_t& leadOpcode) {
+    const uint32_t lead = std::countr_zero(running);
+    const uint16_t leadPc = pc[lead] & 0xFFF;
+    const u8x32 high = load<u8x32>(memory[leadPc].data());
+    const u8x32 low = load<u8x32>(memory[(leadPc + 1) & 0xFFF].data());
+    leadOpcode = high[lead] << 8 | low[lead];
+
+    const s16x32 samePc = load<u16x32>(pc) == pc[lead];
+    const s8x32 sameBytes = (high == high[lead]) & (low == low[lead]);
+    const uint32_t uniform = laneBits(__builtin_convertvector(samePc, s8x32) & sameBytes) & running;
+
+    for(uint32_t bits = running & ~uniform; bits != 0; bits &= bits - 1) {
+        const uint32_t lane = std::countr_zero(bits);
+        const uint16_t p = pc[lane] & 0xFFF;
+        opcode[lane] = memory[p][lane] << 8 | memory[(p + 1) & 0xFFF][lane];
+    }
+    return uniform;
+}
+
+void LockstepEngine::executeGroup(const uint16_t op, const uint32_t group) {
+    // a few lanes are cheaper to run one by one than all 32 masked
+    if(std::popcount(group) < minVectorGroup || !isVectorOpcode(op)) {
+        for(uint32_t bits = group; bits != 0; bits &= bits - 1)
+            executeLane(op, std::countr_zero(bits));
+        return;
+    }
+
+    const uint16_t  nnn = op & 0x0FFF;
+    const uint16_t  n   = op & 0x000F;
+    const uint16_t  x   = (op & 0x0F00) >> 8;
+    const uint16_t  y   = (op & 0x00F0) >> 4;
+    const uint8_t   kk  = op & 0x00FF;
+
+    const s8x32 mask = laneMask(group);
+    const s16x32 mask16 = __builtin_convertvector(mask, s16x32);
+
+    u16x32 PC = load<u16x32>(pc);
+    PC += (u16x32)mask16 & 2;
+
+    u8x32 Vx = load<u8x32>(V[x]);
+    const u8x32 Vy = load<u8x32>(V[y]);
+    u8x32 flag = {};
+    bool writeVx = false;
+    bool writeVF = false;
+
+    switch(op & 0xF000) {
+        case 0x1000: // 0x1NNN: Jump to location NNN
+            PC = select(mask16, u16x32{} + nnn, PC);
+            break;
+        case 0x3000: // 0x3XKK: Skip next instr. if V[X] == KK
+            PC += (u16x32)(mask16 & __builtin_convertvector(Vx == kk, s16x32)) & 2;
+            break;
+        case 0x4000: // 0x4XKK: Skip next instr. if V[X] != KK
+            PC += (u16x32)(mask16 & __builtin_convertvector(Vx != kk, s16x32)) & 2;
+            break;
+        case 0x5000: // 0x5XY0: Skip next instr. if V[X] == V[Y]
+            PC += (u16x32)(mask16 & __builtin_convertvector(Vx == Vy, s16x32)) & 2;
+            break;
+        case 0x6000: // 0x6XKK: V[X] = KK
+            Vx = u8x32{} + kk;
+            writeVx = true;
+            break;
+        case 0x7000: // 0x7XKK: V[X] += KK
+            Vx += kk;
+            writeVx = true;
+            break;
+        case 0x8000:
+            writeVx = true;
+            writeVF = true;
+            switch(n) {
+                case 0x0000: // 0x8XY0: V[X] = V[Y]
+                    Vx = Vy;
+                    writeVF = false;
+                    break;
+                case 0x0001: // 0x8XY1: V[X] OR V[Y]
+                    Vx |= Vy;
+                    break;
+                case 0x0002: // 0x8XY2: V[X] AND V[Y]
+                    Vx &= Vy;
+                    break;
+                case 0x0003: // 0x8XY3: V[X] XOR V[Y]
+                    Vx ^= Vy;
+                    break;
+                case 0x0004: { // 0x8XY4: V[X] ADD V[Y]
+                    const u8x32 sum = Vx + Vy;
+                    flag = (u8x32)(sum < Vx) & 1;
+                    Vx = sum;
+                    break;
+                }
+                case 0x0005: // 0x8XY5: V[X] SUB V[Y]
+                    flag = (u8x32)(Vx >= Vy) & 1;
+                    Vx -= Vy;
+                    break;
+                case 0x0006: // 0x8XY6: V[X] = V[X] / 2
+                    flag = Vx & 1;
+                    Vx = Vy >> 1;
+                    break;
+                case 0x0007: // 0x8XY7: V[X] SUBN V[Y]
+                    flag = (u8x32)(Vy >= Vx) & 1;
+                    Vx = Vy - Vx;
+                    break;
+                case 0x000E: // 0x8XYE: V[X] = V[X] * 2
+                    flag = Vx >> 7;
+                    Vx = Vy << 1;
+                    break;
+                default:
+                    crashed |= group;
+                    writeVx = false;
+                    writeVF = false;
+                    break;
+            }
+            break;
+        case 0x9000: // 0x9XY0: Skip next instr. if V[X] != V[Y]
+            PC += (u16x32)(mask16 & __builtin_convertvector(Vx != Vy, s16x32)) & 2;
+            break;
+        case 0xA000: { // 0xANNN: I = NNN
+            const u16x32 Ivec = load<u16x32>(I);
+            store(I, select(mask16, u16x32{} + nnn, Ivec));
+            break;
+        }
+        case 0xF000:
+            switch(kk) {
+                case 0x0007: // 0xFX07: V[X] = delayTimer
+                    Vx = load<u8x32>(delayTimer);
+                    writeVx = true;
+                    break;
+                case 0x0015: // 0xFX15: delayTimer = V[X]
+                    store(delayTimer, select(mask, Vx, load<u8x32>(delayTimer)));
+                    break;
+                case 0x0018: // 0xFX18: soundTimer = V[X]
+                    store(soundTimer, select(mask, Vx, load<u8x32>(soundTimer)));
+                    break;
+                case 0x001E: { // 0xFX1E: I = I + V[X]
+                    const u16x32 Ivec = load<u16x32>(I);
+                    store(I, select(mask16, Ivec + __builtin_convertvector(Vx, u16x32), Ivec));
+                    break;
+                }
+            }
+            break;
+    }
+
+    store(pc, PC);
+    // V[X] is written before VF, so VF wins for 8FYN like in Chip8::emulateCycle
+    if(writeVx)
+        store(V[x], select(mask, Vx, load<u8x32>(V[x])));
+    if(writeVF)
+        store(V[0xF], select(mask, flag, load<u8x32>(V[0xF])));
+}
+
+// One lane of one opcode, mirrors Chip8::emulateCycle
+void LockstepEngine::executeLane(const uint16_t op, const uint32_t lane) {
+    const uint16_t  nnn = op & 0x0FFF;
+    const uint16_t  n   = op & 0x000F;
+    const uint16_t  x   = (op & 0x0F00) >> 8;
+    const uint16_t  y   = (op & 0x00F0) >> 4;
+    const uint8_t   kk  = op & 0x00FF;
+    uint8_t& Vx = V[x][lane];
+    const uint8_t Vy = V[y][lane];
+    uint8_t flag;
+
+    pc[lane] += 2;
+
+    switch(op & 0xF000) {
+        case 0x0000:
+            switch(n) { // check nibble, like Chip8::emulateCycle
+                case 0x0000: // 0x00E0: Clear screen
+                    frames[lane].fill(0);
+                    break;
+                case 0x000E: // 0x00EE: Return from subroutine
+                    sp[lane] = (sp[lane] - 1) & 0xF;
+                    pc[lane] = stack[sp[lane]][lane];
+                    break;
+                default:
+                    crashed |= 1u << lane;
+                    break;
+            }
+            break;
+        case 0x1000: // 0x1NNN: Jump to location NNN
+            pc[lane] = nnn;
+            break;
+        case 0x2000: // 0x2NNN: Call subroutine at NNN
+            stack[sp[lane] & 0xF][lane] = pc[lane];
+            sp[lane] = (sp[lane] + 1) & 0xF;
+            pc[lane] = nnn;
+            break;
+        case 0x3000: // 0x3XKK: Skip next instr. if V[X] == KK
+            if(Vx == kk)
+                pc[lane] += 2;
+            break;
+        case 0x4000: // 0x4XKK: Skip next instr. if V[X] != KK
+            if(Vx != kk)
+                pc[lane] += 2;
+            break;
+        case 0x5000: // 0x5XY0: Skip next instr. if V[X] == V[Y]
+            if(Vx == Vy)
+                pc[lane] += 2;
+            break;
+        case 0x6000: // 0x6XKK: V[X] = KK
+            Vx = kk;
+            break;
+        case 0x7000: // 0x7XKK: V[X] += KK
+            Vx += kk;
+            break;
+        case 0x8000:
+            switch(n) {
+                case 0x0000: // 0x8XY0: V[X] = V[Y]
+                    Vx = Vy;
+                    return;
+                case 0x0001: // 0x8XY1: V[X] OR V[Y]
+                    flag = 0;
+                    Vx |= Vy;
+                    break;
+                case 0x0002: // 0x8XY2: V[X] AND V[Y]
+                    flag = 0;
+                    Vx &= Vy;
+                    break;
+                case 0x0003: // 0x8XY3: V[X] XOR V[Y]
+                    flag = 0;
+                    Vx ^= Vy;
+                    break;
+                case 0x0004: // 0x8XY4: V[X] ADD V[Y]
+                    flag = Vx + Vy > 255;
+                    Vx += Vy;
+                    break;
+                case 0x0005: // 0x8XY5: V[X] SUB V[Y]
+                    flag = Vx >= Vy;
+                    Vx -= Vy;
+                    break;
+                case 0x0006: // 0x8XY6: V[X] = V[X] / 2
+                    flag = Vx & 1;
+                    Vx = Vy >> 1;
+                    break;
+                case 0x0007: // 0x8XY7: V[X] SUBN V[Y]
+                    flag = Vy >= Vx;
+                    Vx = Vy - Vx;
+                    break;
+                case 0x000E: // 0x8XYE: V[X] = V[X] * 2
+                    flag = Vx >> 7;
+                    Vx = Vy << 1;
+                    break;
+                default:
+                    crashed |= 1u << lane;
+                    return;
+            }
+            // after V[X], so VF wins for 8FYN
+            V[0xF][lane] = flag;
+            break;
+        case 0x9000: // 0x9XY0: Skip next instr. if V[X] != V[Y]
+            if(Vx != Vy)
+                pc[lane] += 2;
+            break;
+        case 0xA000: // 0xANNN: I = NNN
+            I[lane] = nnn;
+            break;
+        case 0xB000: // 0xBNNN: pc = NNN + V[0]
+            pc[lane] = nnn + V[0][lane];
+            break;
+        case 0xC000: // 0xCXKK: V[X] = random byte AND KK
+            Vx = random(lane) & kk;
+            break;
+        case 0xD000: // 0xDXYN: Display n-byte sprite starting at memory location I at (V[X], V[Y]), V[F] = collision
+            drawSprite(lane, n, x, y);
+            break;
+        case 0xE000: {
+            const bool isDown = Vx < 16 && (keypad[lane] >> Vx) & 1;
+            switch(kk) {
+                case 0x009E: // 0xEX9E: Skip next instr. if key with the value of V[X] is pressed
+                    if(isDown)
+                        pc[lane] += 2;
+                    break;
+                case 0x00A1: // 0xEXA1: Skip next instr. if key with the value of V[X] is NOT pressed
+                    if(!isDown)
+                        pc[lane] += 2;
+                    break;
+                default:
+                    crashed |= 1u << lane;
+                    break;
+            }
+            break;
+        }
+        case 0xF000:
+            switch(kk) {
+                case 0x0007: // 0xFX07: V[X] = delayTimer
+                    Vx = delayTimer[lane];
+                    break;
+                case 0x000A: // 0xFX0A: Wait for a key press, store the value of the key in V[X]
+                    if(keypad[lane] == 0)
+                        pc[lane] -= 2;
+                    else
+                        Vx = std::countr_zero(keypad[lane]);
+                    break;
+                case 0x0015: // 0xFX15: delayTimer = V[X]
+                    delayTimer[lane] = Vx;
+                    break;
+                case 0x0018: // 0xFX18: soundTimer = V[X]
+                    soundTimer[lane] = Vx;
+                    break;
+                case 0x001E: // 0xFX1E: I = I + V[X]
+                    I[lane] += Vx;
+                    break;
+                case 0x0029: // 0xFX29: I = location of sprite for digit V[X], same as Chip8::emulateCycle
+                    I[lane] = 4 * Vx;
+                    break;
+                case 0x0033: // 0xFX33: Store BCD representation of V[X] in memory locations I, I+1 and I+2
+                    memory[I[lane] & 0xFFF][lane] = Vx / 100;
+                    memory[(I[lane] + 1) & 0xFFF][lane] = (Vx / 10) % 10;
+                    memory[(I[lane] + 2) & 0xFFF][lane] = Vx % 10;
+                    break;
+                case 0x0055: // 0xFX55: Store registers V[0x0] through V[X] in memory starting at location I
+                    for(uint8_t i = 0; i <= x; ++i, ++I[lane])
+                        memory[I[lane] & 0xFFF][lane] = V[i][lane];
+                    break;
+                case 0x0065: // 0xFX65: Read registers V[0x0] through V[X] from memory starting at location I
+                    for(uint8_t i = 0; i <= x; ++i, ++I[lane])
+                        V[i][lane] = memory[I[lane] & 0xFFF][lane];
+                    break;
+                default:
+                    crashed |= 1u << lane;
+                    break;
+            }
+            break;
+    }
+}
+
+void LockstepEngine::drawSprite(const uint32_t lane, const uint16_t n, const uint16_t x, const uint16_t y) {
+    Frame& frame = frames[lane];
+    // VF is cleared before the coordinates are read, which matters for DFYN / DXFN
+    V[0xF][lane] = 0;
+
+    for(uint16_t i = 0; i < n; ++i) {
+        const uint16_t xcol = V[x][lane] % xRes;
+        const uint16_t yrow = (V[y][lane] % yRes) + i;
+        if(yrow >= yRes)
+            continue;
+
+        // sprite MSB is the leftmost pixel, bit x of a row is pixel x, pixels past the right edge are clipped
+        const uint8_t spriteRow = memory[(I[lane] + i) & 0xFFF][lane];
+        uint64_t bits = 0;
+        for(uint8_t j = 0; j < 8; ++j)
+            bits |= uint64_t((spriteRow >> (7 - j)) & 1) << j;
+        bits <<= xcol;
+
+        if(frame[yrow] & bits)
+            V[0xF][lane] = 1;
+        frame[yrow] ^= bits;
+    }
+}
+
+uint8_t LockstepEngine::random(const uint32_t lane) {
+    // same xorshift32 as Chip8::random, so lanes and Chip8 instances with equal seeds agree
+    uint32_t& state = rngState[lane];
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state >> 24;
+}
@@ -0,0 +1,98 @@
+#ifndef LOCKSTEP_ENGINE_HPP
+#define LOCKSTEP_ENGINE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Memory.hpp"
+#include "Timing.hpp"
+
+/* Runs up to 32 machines (lanes) of the same ROM in lockstep on one core, without Qt.
+     * + registers, I, pc, stack and timers are stored as structure-of-arrays, one column per lane
+     * + memory is interleaved by address (memory[address][lane]), so when all lanes sit on the same pc
+     *   the opcodes of all lanes are fetched with two vector loads
+     * + lanes are grouped by opcode, each group is executed once: register/timer/skip/jump opcodes with
+     *   vector operations over all 32 lanes masked to the group, memory and display opcodes (and groups
+     *   too small to pay off) lane by lane
+     * + lanes are scheduled exactly like Chip8::emulateFrame (cycle budget, display wait), so a lane
+     *   produces the same frames as a Chip8 with the same seed and keys
+     * + unknown opcodes stop the lane instead of the process, see isCrashed()*/
+
+class LockstepEngine {
+public:
+    static constexpr uint32_t maxLanes = 32;
+    static constexpr uint16_t xRes = 64;
+    static constexpr uint16_t yRes = 32;
+
+    using Frame = std::array<uint64_t, yRes>; // same layout as Screen::Frame
+
+    struct LaneState {
+        uint16_t        pc;
+        uint16_t        I;
+        uint16_t        sp;
+        uint8_t         V[16];
+        uint16_t        stack[16];
+        uint8_t         delayTimer;
+        uint8_t         soundTimer;
+        uint32_t        rngState;
+        int64_t         cycleBalance;
+        bool            crashed;
+        Memory::Bytes   memory;
+        Frame           frame;
+    };
+
+    LockstepEngine(const uint32_t laneCount);
+    ~LockstepEngine() = default;
+
+    bool loadRom(const uint8_t* rom, const size_t size);
+    void seed(const uint32_t lane, const uint32_t seed);
+    void reset();
+    void resetLane(const uint32_t lane);
+    void stepFrame(const uint16_t* keypads); // keypads[laneCount], nullptr = no keys
+
+    void saveLane(const uint32_t lane, LaneState& state);
+    void loadLane(const uint32_t lane, const LaneState& state);
+
+    inline uint32_t getLaneCount() { return laneCount; }
+    inline const Frame& getFrame(const uint32_t lane) { return frames[lane]; }
+    inline bool isCrashed(const uint32_t lane) { return (crashed >> lane) & 1; }
+    inline uint8_t peek(const uint32_t lane, const uint16_t address) { return memory[address & 0xFFF][lane]; }
+    inline void setClockScale(const double scale) { clockScale = scale; }
+    inline void setDisplayWait(const bool enabled) { displayWait = enabled; }
+
+private:
+    static constexpr int minVectorGroup = 4;
+
+    uint32_t fetch(const uint32_t running, uint16_t& leadOpcode);
+    void executeGroup(const uint16_t opcode, const uint32_t group);
+    void executeLane(const uint16_t opcode, const uint32_t lane);
+    void drawSprite(const uint32_t lane, const uint16_t n, const uint16_t x, const uint16_t y);
+    uint8_t random(const uint32_t lane);
+
+    uint32_t laneCount;
+    uint32_t crashed;   // bit per lane
+    double clockScale;
+    bool displayWait;
+
+    // structure-of-arrays, padded to maxLanes so every row is one vector
+    alignas(64) uint8_t     V[16][maxLanes];
+    alignas(64) uint16_t    pc[maxLanes];
+    alignas(64) uint16_t    I[maxLanes];
+    alignas(64) uint16_t    sp[maxLanes];
+    alignas(64) uint16_t    stack[16][maxLanes];
+    alignas(64) uint8_t     delayTimer[maxLanes];
+    alignas(64) uint8_t     soundTimer[maxLanes];
+    alignas(64) uint16_t    keypad[maxLanes];
+    alignas(64) uint16_t    opcode[maxLanes];
+    alignas(64) int32_t     cycleBalance[maxLanes];
+    uint32_t                rngSeed[maxLanes];
+    uint32_t                rngState[maxLanes];
+
+    std::array<Frame, maxLanes> frames;
+    std::vector<std::array<uint8_t, maxLanes>> memory; // memory[address][lane]
+    Memory::Bytes bootImage;
+};
+
+#endif // LOCKSTEP_ENGINE_HPP
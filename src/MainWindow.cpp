@@ -4,8 +4,11 @@
 #include <memory>
 #include <iostream>
 
+#include <QActionGroup>
 #include <QImage>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QStandardPaths>
 #include <qobject.h>
 
 #include "Chip8.hpp"
@@ -17,6 +20,31 @@ MainWindow::MainWindow(QWidget *parent)
     ui->setupUi(this);
 
     myChip8 = std::make_unique<Chip8>();
+    recorder = std::make_unique<FrameRecorder>();
+    player = std::make_unique<FramePlayer>(myChip8->getScreen());
+    netplay = std::make_unique<NetplaySession>(*myChip8);
+    sharedState = std::make_unique<SharedStateExporter>();
+    debugger = std::make_unique<Debugger>(*myChip8);
+    myChip8->setDebugger(debugger.get());
+    profiler = std::make_unique<Profiler>(*myChip8);
+    myChip8->setProfiler(profiler.get());
+    library = std::make_unique<RomLibrary>(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/rom-library.json");
+    library->load();
+
+    ui->screenWidget->setScreen(&myChip8->getScreen());
+
+    QActionGroup* filterGroup = new QActionGroup(this);
+    filterGroup->addAction(ui->actionFilterNone);
+    filterGroup->addAction(ui->actionFilterScale2x);
+    filterGroup->addAction(ui->actionFilterScale3x);
+
+    ui->debuggerPane->setTarget(myChip8.get(), debugger.get());
+    ui->profilerPane->setTarget(myChip8.get(), profiler.get());
+    ui->menuView->addSeparator();
+    ui->menuView->addAction(ui->debuggerDock->toggleViewAction());
+    ui->menuView->addAction(ui->profilerDock->toggleViewAction());
+    ui->debuggerDock->hide();
+    ui->profilerDock->hide();
 }
 
 MainWindow::~MainWindow()
@@ -43,6 +71,82 @@ void MainWindow::on_actionReload_triggered() {
 
 }
 
+void MainWindow::on_actionScanLibrary_triggered() {
+    QString directory = QFileDialog::getExistingDirectory(this, "Scan ROM library");
+    if(directory.isEmpty())
+        return;
+
+    const int found = library->scan(directory);
+    library->save();
+    std::cout << "Found " << found << " ROMs in " << directory.toStdString() << std::endl;
+}
+
+bool MainWindow::pickLibraryEntry(const QString& dialogTitle, RomLibrary::Entry& picked) {
+    const std::vector<RomLibrary::Entry> entries = library->getEntries();
+    if(entries.empty()) {
+        std::cout << "The ROM library is empty, scan a directory first!" << std::endl;
+        return false;
+    }
+
+    // titles are not unique, e.g. two versions of one game, the path tells them apart
+    QStringList titles;
+    for(const RomLibrary::Entry& entry : entries)
+        titles << entry.title;
+    QStringList items;
+    for(const RomLibrary::Entry& entry : entries)
+        items << (titles.count(entry.title) > 1 ? entry.title + " (" + entry.path + ")" : entry.title);
+
+    bool ok = false;
+    const QString item = QInputDialog::getItem(this, dialogTitle, "ROM:", items, 0, false, &ok);
+    if(!ok)
+        return false;
+    picked = entries[items.indexOf(item)];
+    return true;
+}
+
+void MainWindow::on_actionOpenFromLibrary_triggered() {
+    RomLibrary::Entry entry {};
+    if(!pickLibraryEntry("Open from library", entry))
+        return;
+
+    const bool wasRunning = myChip8->isRunning();
+    if(wasRunning)
+        myChip8->stop();
+    if(!library->loadRom(entry, *myChip8)) {
+        std::cout << "Could not load " << entry.title.toStdString() << " from the library!" << std::endl;
+        return;
+    }
+    if(wasRunning)
+        myChip8->start();
+}
+
+void MainWindow::on_actionEditLibraryEntry_triggered() {
+    RomLibrary::Entry entry {};
+    if(!pickLibraryEntry("Edit library entry", entry))
+        return;
+
+    bool ok = false;
+    const QString title = QInputDialog::getText(this, "Edit library entry", "Title:", QLineEdit::Normal, entry.title, &ok);
+    if(!ok || title.isEmpty())
+        return;
+
+    const QStringList displayWaitModes { "Off", "On" };
+    const QString displayWait = QInputDialog::getItem(this, "Edit library entry", "Display wait:", displayWaitModes,
+        entry.displayWait ? 1 : 0, false, &ok);
+    if(!ok)
+        return;
+
+    const double clockScale = QInputDialog::getDouble(this, "Edit library entry", "Clock scale (1 = COSMAC VIP):",
+        entry.clockScale, 0.1, 1000.0, 2, &ok);
+    if(!ok)
+        return;
+
+    // the profile applies the next time the ROM is opened from the library
+    library->setTitle(entry.hash, title);
+    library->setProfile(entry.hash, displayWait == "On", clockScale);
+    library->save();
+}
+
 void MainWindow::on_actionStartEmulator_triggered() {
     myChip8->start();
 }
@@ -52,16 +156,119 @@ void MainWindow::on_actionStopEmulator_triggered() {
 }
 
 void MainWindow::on_actionStepEmulator_triggered() {
-    myChip8->emulateCycle();
+    debugger->step();
 }
 
 void MainWindow::on_actionPauseEmulator_triggered() {
+    // resuming through the debugger, so a breakpoint it stopped at doesn't stop it again
     if(myChip8->isPaused())
-        myChip8->unPause();
+        debugger->resume();
     else
         myChip8->pause();
 }
 
+void MainWindow::on_actionRecord_toggled(bool checked) {
+    if(!checked) {
+        myChip8->setRecorder(nullptr);
+        recorder->close();
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Record session", "", " Frame streams (*.c8fs)");
+    if(fileName.isEmpty() || !recorder->open(fileName.toStdString())) {
+        ui->actionRecord->setChecked(false);
+        return;
+    }
+    myChip8->setRecorder(recorder.get());
+}
+
+void MainWindow::on_actionReplay_triggered() {
+    QString fileName = QFileDialog::getOpenFileName(this, "Replay session", "", " Frame streams (*.c8fs)");
+    if(fileName.isEmpty())
+        return;
+
+    if(myChip8->isAlive())
+        myChip8->stop();
+    if(player->open(fileName.toStdString()))
+        player->start();
+}
+
+void MainWindow::on_actionHostNetplay_triggered() {
+    bool ok = false;
+    QString socketPath = QInputDialog::getText(this, "Host netplay", "Socket:", QLineEdit::Normal, defaultNetplaySocket, &ok);
+    if(!ok || socketPath.isEmpty())
+        return;
+
+    // the emulator waits for the peer to connect once started
+    myChip8->setNetplaySession(nullptr);
+    if(netplay->host(socketPath.toStdString()))
+        myChip8->setNetplaySession(netplay.get());
+}
+
+void MainWindow::on_actionJoinNetplay_triggered() {
+    bool ok = false;
+    QString socketPath = QInputDialog::getText(this, "Join netplay", "Socket:", QLineEdit::Normal, defaultNetplaySocket, &ok);
+    if(!ok || socketPath.isEmpty())
+        return;
+
+    myChip8->setNetplaySession(nullptr);
+    if(netplay->join(socketPath.toStdString()))
+        myChip8->setNetplaySession(netplay.get());
+}
+
+void MainWindow::on_actionExportState_toggled(bool checked) {
+    if(!checked) {
+        myChip8->setSharedStateExporter(nullptr);
+        sharedState->close();
+        return;
+    }
+
+    bool ok = false;
+    QString name = QInputDialog::getText(this, "Export shared state", "Shared memory name:", QLineEdit::Normal, defaultSharedStateName, &ok);
+    if(!ok || name.isEmpty() || !sharedState->open(name.toStdString())) {
+        ui->actionExportState->setChecked(false);
+        return;
+    }
+    myChip8->setSharedStateExporter(sharedState.get());
+}
+
+void MainWindow::on_actionProfile_toggled(bool checked) {
+    if(checked) {
+        bool ok = false;
+        const QStringList modes { "Exact", "Sampled" };
+        const QString mode = QInputDialog::getItem(this, "Profile", "Mode:", modes, 0, false, &ok);
+        if(!ok) {
+            ui->actionProfile->setChecked(false);
+            return;
+        }
+        profiler->start(mode == "Exact" ? Profiler::Mode::Exact : Profiler::Mode::Sampled);
+        // the pane refreshes itself while profiling
+        ui->profilerDock->show();
+        return;
+    }
+
+    profiler->stop();
+    ui->profilerPane->refresh();
+    // the whole annotated program does not fit the pane
+    profiler->printProgram(std::cout);
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Save flamegraph", "", " Collapsed stacks (*.folded)");
+    if(!fileName.isEmpty())
+        profiler->writeFlamegraph(fileName.toStdString());
+}
+
+void MainWindow::on_actionFilterNone_triggered() {
+    ui->screenWidget->setFilter(Upscaler::Filter::None);
+}
+
+void MainWindow::on_actionFilterScale2x_triggered() {
+    ui->screenWidget->setFilter(Upscaler::Filter::Scale2x);
+}
+
+void MainWindow::on_actionFilterScale3x_triggered() {
+    ui->screenWidget->setFilter(Upscaler::Filter::Scale3x);
+}
+
 void MainWindow::keyPressEvent(QKeyEvent* event) {
     if(event->text().size() >= 1)
     {
@@ -85,10 +292,18 @@ void MainWindow::keyReleaseEvent(QKeyEvent* event) {
 void MainWindow::closeEvent(QCloseEvent *event) {
     Q_UNUSED(event)
 
-    if(myChip8->isAlive() && !myChip8->isPaused())
-    {
+    // detached at a frame boundary, the debugger and profiler are destroyed before myChip8
+    myChip8->setRecorder(nullptr);
+    myChip8->setNetplaySession(nullptr);
+    myChip8->setDebugger(nullptr);
+    myChip8->setProfiler(nullptr);
+    myChip8->setSharedStateExporter(nullptr);
+    recorder->close();
+    sharedState->close();
+    player->stop();
+
+    // a paused emulator (e.g. stopped at a breakpoint) still runs its thread
+    if(myChip8->isRunning())
         myChip8->stop();
-        myChip8->wait();
-    }
 }
 
@@ -7,6 +7,13 @@
 #include <QKeyEvent>
 
 #include "Chip8.hpp"
+#include "Debugger.hpp"
+#include "FrameRecorder.hpp"
+#include "FramePlayer.hpp"
+#include "NetplaySession.hpp"
+#include "Profiler.hpp"
+#include "RomLibrary.hpp"
+#include "SharedStateExporter.hpp"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -26,18 +33,40 @@ private slots:
     // This slot naming convention automatically connects actions to slots
     void on_actionLoad_triggered();
     void on_actionReload_triggered();
+    void on_actionScanLibrary_triggered();
+    void on_actionOpenFromLibrary_triggered();
+    void on_actionEditLibraryEntry_triggered();
     void on_actionStartEmulator_triggered();
     void on_actionStopEmulator_triggered();
     void on_actionStepEmulator_triggered();
     void on_actionPauseEmulator_triggered();
+    void on_actionRecord_toggled(bool checked);
+    void on_actionReplay_triggered();
+    void on_actionHostNetplay_triggered();
+    void on_actionJoinNetplay_triggered();
+    void on_actionExportState_toggled(bool checked);
+    void on_actionProfile_toggled(bool checked);
+    void on_actionFilterNone_triggered();
+    void on_actionFilterScale2x_triggered();
+    void on_actionFilterScale3x_triggered();
 
 private:
+    bool pickLibraryEntry(const QString& dialogTitle, RomLibrary::Entry& picked);
     void keyReleaseEvent(QKeyEvent* event);
     void keyPressEvent(QKeyEvent* event);
     void closeEvent(QCloseEvent* event);
 
     Ui::MainWindow *ui;
     std::unique_ptr<Chip8> myChip8;
+    std::unique_ptr<FrameRecorder> recorder;
+    std::unique_ptr<FramePlayer> player;
+    std::unique_ptr<NetplaySession> netplay;
+    std::unique_ptr<Debugger> debugger;
+    std::unique_ptr<Profiler> profiler;
+    std::unique_ptr<RomLibrary> library;
+    std::unique_ptr<SharedStateExporter> sharedState;
+    const QString defaultNetplaySocket = "/tmp/chip8-netplay.sock";
+    const QString defaultSharedStateName = "/chip8-state";
     std::map<char, unsigned char> keyMap {
         {'x', 0x0},
         {'1', 0x1},
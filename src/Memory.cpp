@@ -1,50 +1,66 @@
 #include <algorithm>
 #include <cstdint>
 #include <iostream>
-#include <memory>
 #include <qbytearrayalgorithms.h>
 #include <qstringview.h>
 
-#include "Memory.hpp"
+#include <QByteArray>
 
-uint16_t Memory::programSize;
+#include "Memory.hpp"
+#include "Disassembler.hpp"
 
 Memory::Memory()
-    : fileIsLoaded(false) {
-    programSize = 0;
-    arr = std::make_shared<std::array<uint8_t, memorySize>>();
+    : programSize(0),
+    fileIsLoaded(false) {
     clear();
-    std::copy(fontset.begin(), fontset.end(), arr->begin());
+    std::copy(fontset.begin(), fontset.end(), arr.begin());
 }
 
 void Memory::clear() {
-    std::fill(arr->begin() + fontsetSize, arr->end(), 0);
+    std::fill(arr.begin() + fontsetSize, arr.end(), 0);
     fileIsLoaded = false;
 }
 
-void Memory::loadFile(const QByteArray& fileContent) {
-    clear();
+bool Memory::loadFile(const QByteArray& fileContent) {
+    return loadFile(reinterpret_cast<const uint8_t*>(fileContent.constData()), fileContent.size());
+}
 
-    programSize = fileContent.size() - 1;
+bool Memory::loadFile(const uint8_t* data, const size_t size) {
+    clear();
 
-    for(uint16_t i = 0; i < programSize; ++i) {
-        arr->at(i + programBegin) = fileContent.at(i);
+    if(size > memorySize - programBegin) {
+        std::cout << "ROM is too big: " << size << " bytes, at most " << memorySize - programBegin << " fit!" << std::endl;
+        return false;
     }
 
+    programSize = size;
+    std::copy_n(data, size, arr.begin() + programBegin);
+
     fileIsLoaded = true;
+    return true;
 }
 
-void Memory::printProgram() {
-    std::cout   << "###### Program START ###### " << std::endl
-                << "opcode index : [memory addresses] : <opcode>" << std::endl;
-    
-    for(uint16_t i = programBegin; i < programBegin+programSize; i+=2)
-        std::cout << std::dec << i - programBegin  << " : [" << i << "-" << i+1 << "] : " << std::hex << getOpcode(i) << std::endl;
-    
-    std::cout << "###### Program END ###### " << std::endl;
+void Memory::setBytes(const Bytes& bytes) {
+    // a restored memory image always contains a program
+    arr = bytes;
+    fileIsLoaded = true;
+}
+
+void Memory::printProgram(std::ostream& out, const std::function<std::string(uint16_t)>& annotate) {
+    out << "###### Program START ######" << std::endl;
+
+    // every opcode needs both of its bytes
+    const uint16_t programEnd = std::min<uint16_t>(programBegin + programSize, memorySize - 1);
+    for(uint16_t address = programBegin; address < programEnd; address += 2) {
+        if(annotate)
+            out << annotate(address);
+        out << Disassembler::formatLine(address, getOpcode(address)) << '\n';
+    }
+
+    out << "###### Program END ######" << std::endl;
 }
 
 const uint16_t Memory::getOpcode(const uint16_t& pc) {
-    return (*arr)[pc] << 8 | (*arr)[pc+1];
+    return arr[pc] << 8 | arr[pc+1];
 }
 
@@ -2,11 +2,13 @@
 #define MEMORY_HPP
 
 #include <array>
-#include <memory>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <iostream>
 #include <string>
 
-#include <QByteArray>
+class QByteArray;
 
 /* CHIP-8 has 4KB memory (4096 bytes), from location 0x000 (0) to 0xFFF (4095):
      * + 0x000 (0) to 0x1FF (511) - CHIP-8 interpreter
@@ -14,21 +16,25 @@
 
 class Memory {
 public:
+    static constexpr uint16_t memorySize = 4096;
+    using Bytes = std::array<uint8_t, memorySize>;
+
     Memory();
     ~Memory() = default;
 
     void clear();
-    void printProgram();
-    void loadFile(const QByteArray& fileContent);
+    // disassembly of the loaded program, annotate can put columns in front of every line
+    void printProgram(std::ostream& out = std::cout, const std::function<std::string(uint16_t)>& annotate = nullptr);
+    bool loadFile(const QByteArray& fileContent);
+    bool loadFile(const uint8_t* data, const size_t size); // copied to programBegin, data can be a mapped file
     inline bool isFileLoaded() { return fileIsLoaded; }
     const uint16_t getOpcode(const uint16_t& pc);
-    inline const uint8_t& operator[](const uint16_t idx) const { return (*arr)[idx]; }
-    inline uint8_t& operator[](const uint16_t idx) { return (*arr)[idx]; }
+    inline const uint8_t& operator[](const uint16_t idx) const { return arr[idx]; }
+    inline uint8_t& operator[](const uint16_t idx) { return arr[idx]; }
+    inline Bytes& getBytes() { return arr; }
+    void setBytes(const Bytes& bytes);
 
     static constexpr uint16_t programBegin = 512;
-
-private:
-    static constexpr uint16_t memorySize = 4096;
     static constexpr uint8_t fontsetSize = 80;
     static constexpr std::array<uint8_t, fontsetSize> fontset { 
         0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
@@ -48,9 +54,10 @@ private:
         0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
         0xF0, 0x80, 0xF0, 0x80, 0x80  // F
     };
-    static uint16_t programSize;
 
-    std::shared_ptr<std::array<uint8_t, memorySize>> arr;
+private:
+    Bytes arr;
+    uint16_t programSize;
     std::string prevFilename;
     bool fileIsLoaded;
 };
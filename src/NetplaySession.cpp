@@ -0,0 +1,265 @@
+#include "NetplaySession.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+NetplaySession::NetplaySession(Chip8& chip8) :
+    chip8(chip8),
+    role(Role::None),
+    listenFd(-1),
+    fd(-1),
+    handshakeDone(false),
+    currentFrame(0),
+    lastRemoteFrame(noFrame),
+    rollbackFrame(noFrame),
+    receivedBytes(0),
+    rollbackCount(0),
+    resimulatedFrames(0) {
+}
+
+NetplaySession::~NetplaySession() {
+    close();
+}
+
+bool NetplaySession::host(const std::string& path) {
+    close();
+
+    sockaddr_un address {};
+    if(path.size() >= sizeof(address.sun_path)) {
+        std::cout << "Netplay socket path is too long: " << path << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if(listenFd < 0
+        || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || listen(listenFd, 1) < 0) {
+        std::cout << "Could not host netplay on " << path << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    // the peer is accepted from advanceFrame(), the emulator stalls until then
+    fcntl(listenFd, F_SETFL, O_NONBLOCK);
+
+    socketPath = path;
+    role = Role::Host;
+    return true;
+}
+
+bool NetplaySession::join(const std::string& path) {
+    close();
+
+    sockaddr_un address {};
+    if(path.size() >= sizeof(address.sun_path)) {
+        std::cout << "Netplay socket path is too long: " << path << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cout << "Could not join netplay on " << path << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    role = Role::Join;
+    return true;
+}
+
+bool NetplaySession::connectLocal(NetplaySession& peer) {
+    close();
+    peer.close();
+
+    int fds[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        std::cout << "Could not create netplay socket pair: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    fd = fds[0];
+    role = Role::Host;
+    peer.fd = fds[1];
+    peer.role = Role::Join;
+    return true;
+}
+
+void NetplaySession::close() {
+    if(fd >= 0)
+        ::close(fd);
+    if(listenFd >= 0)
+        ::close(listenFd);
+    if(!socketPath.empty())
+        unlink(socketPath.c_str());
+
+    fd = -1;
+    listenFd = -1;
+    socketPath.clear();
+    role = Role::None;
+    handshakeDone = false;
+    currentFrame = 0;
+    lastRemoteFrame = noFrame;
+    rollbackFrame = noFrame;
+    receivedBytes = 0;
+}
+
+bool NetplaySession::handshake() {
+    if(role == Role::Host && fd < 0) {
+        fd = accept(listenFd, nullptr, nullptr);
+        if(fd < 0)
+            return false;
+    }
+
+    if(role == Role::Host) {
+        const Hello hello { helloMagic, chip8.getSeed(), romChecksum(), chip8.getDisplayWait(), chip8.getFrameBudget() };
+        if(send(fd, &hello, sizeof(hello), MSG_NOSIGNAL) != sizeof(hello))
+            return false;
+    }
+    else {
+        // the host may not have accepted yet, don't block the emulation thread on it
+        Hello hello;
+        if(recv(fd, &hello, sizeof(hello), MSG_PEEK | MSG_DONTWAIT) != sizeof(hello))
+            return false;
+        if(!receiveExact(&hello, sizeof(hello)) || hello.magic != helloMagic) {
+            std::cout << "Netplay handshake failed!" << std::endl;
+            close();
+            return false;
+        }
+        if(hello.romChecksum != romChecksum()) {
+            std::cout << "Netplay peers have different ROMs loaded!" << std::endl;
+            close();
+            return false;
+        }
+        // a different clock scale or display wait runs a different number of instructions per frame
+        if(hello.frameBudget != chip8.getFrameBudget() || bool(hello.displayWait) != chip8.getDisplayWait()) {
+            std::cout << "Netplay peers have different quirk settings (clock scale, display wait)!" << std::endl;
+            close();
+            return false;
+        }
+        // both machines have to generate the same random numbers
+        chip8.seed(hello.seed);
+    }
+
+    handshakeDone = true;
+    return true;
+}
+
+void NetplaySession::advanceFrame(const uint16_t localKeys) {
+    // not (or no longer) connected, keep playing locally
+    if(role == Role::None) {
+        chip8.emulateFrame(localKeys);
+        return;
+    }
+    if(!handshakeDone && !handshake())
+        return;
+    if(!receiveInputs())
+        return;
+
+    // too far ahead of the remote peer to roll back, wait for its input
+    const uint32_t confirmedFrames = lastRemoteFrame == noFrame ? 0 : lastRemoteFrame + 1;
+    if(currentFrame >= confirmedFrames + maxRollbackFrames)
+        return;
+
+    if(!sendInput(currentFrame, localKeys))
+        return;
+    localInputs[currentFrame % historySize] = localKeys;
+
+    if(rollbackFrame != noFrame) {
+        chip8.loadState(states[rollbackFrame % historySize]);
+        for(uint32_t frame = rollbackFrame; frame < currentFrame; ++frame) {
+            const uint32_t slot = frame % historySize;
+            if(frame != rollbackFrame)
+                chip8.saveState(states[slot]);
+            usedRemoteInputs[slot] = predictRemote(frame);
+            chip8.emulateFrame(localInputs[slot] | usedRemoteInputs[slot]);
+        }
+        rollbackCount++;
+        resimulatedFrames += currentFrame - rollbackFrame;
+        rollbackFrame = noFrame;
+    }
+
+    const uint32_t slot = currentFrame % historySize;
+    chip8.saveState(states[slot]);
+    usedRemoteInputs[slot] = predictRemote(currentFrame);
+    chip8.emulateFrame(localKeys | usedRemoteInputs[slot]);
+    currentFrame++;
+}
+
+bool NetplaySession::receiveInputs() {
+    while(true) {
+        const ssize_t received = recv(fd, receiveBuffer.data() + receivedBytes, receiveBuffer.size() - receivedBytes, MSG_DONTWAIT);
+        if(received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            std::cout << "Netplay peer disconnected!" << std::endl;
+            close();
+            return false;
+        }
+        if(received < 0)
+            return true;
+
+        receivedBytes += received;
+        if(receivedBytes < receiveBuffer.size())
+            continue;
+        receivedBytes = 0;
+
+        Message message;
+        std::memcpy(&message, receiveBuffer.data(), sizeof(message));
+
+        const uint32_t slot = message.frame % historySize;
+        remoteInputs[slot] = message.keys;
+        lastRemoteFrame = message.frame;
+
+        if(message.frame < currentFrame && usedRemoteInputs[slot] != message.keys)
+            rollbackFrame = std::min(rollbackFrame, message.frame);
+    }
+}
+
+bool NetplaySession::sendInput(const uint32_t frame, const uint16_t keys) {
+    const Message message { frame, keys, 0 };
+    if(send(fd, &message, sizeof(message), MSG_NOSIGNAL) != sizeof(message)) {
+        std::cout << "Netplay peer disconnected!" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool NetplaySession::receiveExact(void* data, const size_t size) {
+    size_t received = 0;
+    while(received < size) {
+        const ssize_t n = recv(fd, static_cast<uint8_t*>(data) + received, size - received, 0);
+        if(n <= 0)
+            return false;
+        received += n;
+    }
+    return true;
+}
+
+uint16_t NetplaySession::predictRemote(const uint32_t frame) {
+    if(lastRemoteFrame == noFrame)
+        return 0;
+    if(frame <= lastRemoteFrame)
+        return remoteInputs[frame % historySize];
+    return remoteInputs[lastRemoteFrame % historySize];
+}
+
+uint32_t NetplaySession::romChecksum() {
+    // FNV-1a over the whole memory, which holds nothing but the fontset and the ROM before the first frame
+    uint32_t hash = 2166136261u;
+    for(const uint8_t byte : chip8.getMemory().getBytes()) {
+        hash ^= byte;
+        hash *= 16777619u;
+    }
+    return hash;
+}
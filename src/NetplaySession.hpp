@@ -0,0 +1,86 @@
+#ifndef NETPLAY_SESSION_HPP
+#define NETPLAY_SESSION_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "Chip8.hpp"
+
+/* Rollback netplay between two Chip8 instances over a UNIX stream socket.
+     * + peers only exchange the keypad state of every frame, both machines see local | remote keys
+     * + missing remote input is predicted by repeating the last received one
+     * + a misprediction restores the snapshot of that frame and resimulates up to the present
+     * + a peer more than maxRollbackFrames ahead of the confirmed input stalls until the other side catches up*/
+
+class NetplaySession {
+public:
+    NetplaySession(Chip8& chip8);
+    ~NetplaySession();
+
+    // host(), join(), connectLocal() and close() reset the session, detach it first (Chip8::setNetplaySession(nullptr))
+    bool host(const std::string& socketPath);
+    bool join(const std::string& socketPath);
+    bool connectLocal(NetplaySession& peer); // both peers in this process
+    void close();
+
+    void advanceFrame(const uint16_t localKeys); // called once per frame from the emulation thread
+    inline bool isConnected() { return handshakeDone; }
+    inline uint32_t getFrame() { return currentFrame; }
+    inline uint64_t getRollbackCount() { return rollbackCount; }
+    inline uint64_t getResimulatedFrames() { return resimulatedFrames; }
+
+private:
+    enum class Role { None, Host, Join };
+
+    struct Message {
+        uint32_t frame;
+        uint16_t keys;
+        uint16_t reserved;
+    };
+
+    // everything both peers have to agree on to emulate the same frames
+    struct Hello {
+        uint32_t magic;
+        uint32_t seed;
+        uint32_t romChecksum;
+        uint32_t displayWait;
+        int64_t frameBudget;    // Chip8::getFrameBudget(), covers the clock scale
+    };
+
+    static constexpr uint32_t helloMagic = 0x504E3843; // "C8NP"
+    static constexpr uint32_t maxRollbackFrames = 8;
+    static constexpr uint32_t historySize = 32;         // has to cover frames in both directions of the rollback window
+    static constexpr uint32_t noFrame = UINT32_MAX;
+
+    bool handshake();
+    bool receiveInputs();
+    bool sendInput(const uint32_t frame, const uint16_t keys);
+    bool receiveExact(void* data, const size_t size);
+    uint16_t predictRemote(const uint32_t frame);
+    uint32_t romChecksum();
+
+    Chip8& chip8;
+    Role role;
+    int listenFd;
+    int fd;
+    std::string socketPath;
+    bool handshakeDone;
+
+    uint32_t currentFrame;
+    uint32_t lastRemoteFrame;   // every remote input up to this frame has been received
+    uint32_t rollbackFrame;     // earliest frame that was simulated with a wrong prediction
+
+    std::array<Chip8::State, historySize> states; // state at the start of every frame
+    std::array<uint16_t, historySize> localInputs;
+    std::array<uint16_t, historySize> remoteInputs;
+    std::array<uint16_t, historySize> usedRemoteInputs;
+
+    std::array<uint8_t, sizeof(Message)> receiveBuffer;
+    size_t receivedBytes;
+
+    uint64_t rollbackCount;
+    uint64_t resimulatedFrames;
+};
+
+#endif // NETPLAY_SESSION_HPP
@@ -0,0 +1,146 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include <QMutexLocker>
+
+#include "Chip8.hpp"
+#include "StringFormat.hpp"
+
+Profiler::Profiler(Chip8& target) :
+    chip8(target),
+    current(root),
+    countdown(defaultSampleInterval),
+    running(false),
+    restartPending(false),
+    mode(Mode::Exact),
+    sampleInterval(defaultSampleInterval) {
+    nodes.emplace_back(Memory::programBegin, root);
+    reset();
+}
+
+void Profiler::start(const Mode profilingMode, const uint32_t interval) {
+    reset();
+    sampleInterval = std::max<uint32_t>(interval, 1);
+    mode = profilingMode;
+    restartPending = true;
+    running = true;
+}
+
+void Profiler::stop() {
+    running = false;
+}
+
+void Profiler::reset() {
+    for(uint16_t address = 0; address < Memory::memorySize; ++address) {
+        counts[address] = 0;
+        cycles[address] = 0;
+    }
+    // the tree itself stays, nodes of paths that are not taken again are skipped in the export
+    QMutexLocker locker(&mutex);
+    for(Node& node : nodes)
+        node.cycles = 0;
+}
+
+uint64_t Profiler::getTotalCycles() {
+    uint64_t total = 0;
+    for(const std::atomic<uint64_t>& cycle : cycles)
+        total += cycle.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::vector<Profiler::Hotspot> Profiler::getHotspots(const size_t limit) {
+    const uint64_t total = getTotalCycles();
+    std::vector<Hotspot> hotspots;
+    for(uint16_t address = 0; address < Memory::memorySize; ++address) {
+        if(getCount(address) == 0)
+            continue;
+        hotspots.push_back({ address, getCount(address), getCycles(address), double(getCycles(address)) / total });
+    }
+
+    const size_t count = std::min(limit, hotspots.size());
+    std::partial_sort(hotspots.begin(), hotspots.begin() + count, hotspots.end(), [](const Hotspot& a, const Hotspot& b) {
+        return a.cycles > b.cycles;
+    });
+    hotspots.resize(count);
+    return hotspots;
+}
+
+void Profiler::printProgram(std::ostream& out) {
+    const uint64_t total = std::max<uint64_t>(getTotalCycles(), 1);
+    chip8.getMemory().printProgram(out, [this, total](const uint16_t address) -> std::string {
+        if(getCount(address) == 0)
+            return std::string(35, ' ');
+        return format("%6.2f%% %12llu %12llu  ", getCycles(address) * 100.0 / total,
+            (unsigned long long)getCycles(address), (unsigned long long)getCount(address));
+    });
+}
+
+bool Profiler::writeFlamegraph(const std::string& fileName) {
+    std::ofstream file(fileName);
+    if(!file.is_open()) {
+        std::cout << "Could not write flamegraph " << fileName << std::endl;
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    for(uint32_t node = 0; node < nodes.size(); ++node) {
+        const uint64_t nodeCycles = nodes[node].cycles.load(std::memory_order_relaxed);
+        if(nodeCycles != 0)
+            file << path(node) << ' ' << nodeCycles << '\n';
+    }
+    return file.good();
+}
+
+void Profiler::beginFrame() {
+    // counts recorded by a frame that was in progress during start() belong to the old run
+    if(restartPending.exchange(false)) {
+        reset();
+        countdown = sampleInterval.load(std::memory_order_relaxed);
+        current = root;
+    }
+    // the stack may have changed without a call or return, e.g. after loading a state
+    if(mode.load(std::memory_order_relaxed) == Mode::Exact)
+        current = nodeFromStack();
+}
+
+void Profiler::sample(const uint16_t pc, const uint32_t cost) {
+    current = nodeFromStack();
+    add(pc, cost, sampleInterval.load(std::memory_order_relaxed));
+}
+
+uint32_t Profiler::child(const uint32_t parent, const uint16_t entry) {
+    for(const uint32_t node : nodes[parent].children) {
+        if(nodes[node].entry == entry)
+            return node;
+    }
+    if(nodes.size() >= maxNodes)
+        return parent;
+
+    QMutexLocker locker(&mutex);
+    const uint32_t node = nodes.size();
+    nodes.emplace_back(entry, parent);
+    nodes[parent].children.push_back(node);
+    return node;
+}
+
+uint32_t Profiler::nodeFromStack() {
+    // every stack entry is the return address of a 2NNN, NNN is the subroutine it called
+    Memory& memory = chip8.getMemory();
+    const uint16_t depth = std::min<uint16_t>(chip8.getSp(), 16);
+    uint32_t node = root;
+    for(uint8_t level = 0; level < depth; ++level) {
+        const uint16_t callSite = (chip8.getStack(level) - 2) & 0xFFF;
+        node = child(node, memory.getOpcode(callSite) & 0x0FFF);
+    }
+    return node;
+}
+
+std::string Profiler::path(uint32_t node) {
+    std::string frames = format("0x%03X", nodes[node].entry);
+    for(; node != root; node = nodes[node].parent)
+        frames = format("0x%03X;", nodes[nodes[node].parent].entry) + frames;
+    return frames;
+}
@@ -0,0 +1,117 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <QMutex>
+
+#include "Memory.hpp"
+
+class Chip8;
+
+/* Executed instructions and emulated VIP cycles per pc for one Chip8.
+     * + Exact records every instruction and follows 2NNN / 00EE through a calling context tree
+     * + Sampled records every sampleInterval-th instruction with sampleInterval times its weight and takes the
+     *   call stack from the Chip8 stack, the emulator only decrements a counter in between
+     * + Chip8 only calls record() while the profiler runs, otherwise its loop has no profiling code at all
+     * + the call tree is exported as collapsed stacks ("0x200;0x2A4;0x310 cycles") for flamegraph.pl / speedscope*/
+
+class Profiler {
+public:
+    enum class Mode : uint8_t { Exact, Sampled };
+
+    struct Hotspot {
+        uint16_t address;
+        uint64_t count;
+        uint64_t cycles;
+        double share;       // of all recorded cycles, 0-1
+    };
+
+    static constexpr uint32_t defaultSampleInterval = 97; // prime, so it does not beat with loop lengths
+
+    Profiler(Chip8& target);
+    ~Profiler() = default;
+
+    // the emulation thread picks up a restart at its next beginFrame(), a frame in progress keeps its call path
+    void start(const Mode mode, const uint32_t interval = defaultSampleInterval);
+    void stop();
+    void reset();   // clears the counters, only touches atomics
+    inline bool isRunning() { return running.load(std::memory_order_relaxed); }
+    inline Mode getMode() { return mode.load(std::memory_order_relaxed); }
+    inline uint64_t getCount(const uint16_t address) { return counts[address & 0xFFF].load(std::memory_order_relaxed); }
+    inline uint64_t getCycles(const uint16_t address) { return cycles[address & 0xFFF].load(std::memory_order_relaxed); }
+    uint64_t getTotalCycles();
+
+    std::vector<Hotspot> getHotspots(const size_t limit); // sorted by share
+    void printProgram(std::ostream& out); // the whole program with share, cycles and count in front of every line
+    bool writeFlamegraph(const std::string& fileName);
+
+    // Called by the emulation thread
+    void beginFrame();
+    inline void record(const uint16_t pc, const uint16_t opcode, const uint32_t cost) {
+        if(mode.load(std::memory_order_relaxed) == Mode::Exact) {
+            add(pc, cost, 1);
+            follow(opcode);
+            return;
+        }
+        if(--countdown != 0)
+            return;
+        countdown = sampleInterval.load(std::memory_order_relaxed);
+        sample(pc, cost);
+    }
+
+private:
+    // one node per distinct call path, nodes are never removed so the emulation thread can keep indices
+    struct Node {
+        Node(const uint16_t entry, const uint32_t parent) : entry(entry), parent(parent), cycles(0) {}
+
+        uint16_t entry;     // address of the subroutine
+        uint32_t parent;
+        std::atomic<uint64_t> cycles;
+        std::vector<uint32_t> children;
+    };
+
+    static constexpr uint32_t root = 0;
+    static constexpr uint32_t maxNodes = 1 << 14; // deeper paths are charged to their caller
+
+    inline void add(const uint16_t pc, const uint64_t cost, const uint64_t weight) {
+        std::atomic<uint64_t>& count = counts[pc & 0xFFF];
+        std::atomic<uint64_t>& cycle = cycles[pc & 0xFFF];
+        count.store(count.load(std::memory_order_relaxed) + weight, std::memory_order_relaxed);
+        cycle.store(cycle.load(std::memory_order_relaxed) + cost * weight, std::memory_order_relaxed);
+        std::atomic<uint64_t>& node = nodes[current].cycles;
+        node.store(node.load(std::memory_order_relaxed) + cost * weight, std::memory_order_relaxed);
+    }
+    inline void follow(const uint16_t opcode) {
+        if((opcode & 0xF000) == 0x2000)
+            current = child(current, opcode & 0x0FFF);
+        else if(opcode == 0x00EE && current != root)
+            current = nodes[current].parent;
+    }
+    void sample(const uint16_t pc, const uint32_t cost);
+    uint32_t child(const uint32_t parent, const uint16_t entry);
+    uint32_t nodeFromStack();
+    std::string path(uint32_t node);
+
+    Chip8& chip8;
+    std::array<std::atomic<uint64_t>, Memory::memorySize> counts;
+    std::array<std::atomic<uint64_t>, Memory::memorySize> cycles;
+
+    QMutex mutex;   // guards adding nodes, the emulation thread reads them without it
+    std::deque<Node> nodes;
+    uint32_t current;   // owned by the emulation thread
+    uint32_t countdown; // owned by the emulation thread
+
+    std::atomic<bool> running;
+    std::atomic<bool> restartPending; // start() was called, beginFrame() resets current and countdown
+    std::atomic<Mode> mode;
+    std::atomic<uint32_t> sampleInterval;
+};
+
+#endif // PROFILER_HPP
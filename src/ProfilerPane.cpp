@@ -0,0 +1,68 @@
+#include "ProfilerPane.hpp"
+
+#include <QFontDatabase>
+#include <QHeaderView>
+#include <QStringList>
+#include <QVBoxLayout>
+
+#include "Disassembler.hpp"
+#include "StringFormat.hpp"
+
+ProfilerPane::ProfilerPane(QWidget *parent) :
+    QWidget(parent),
+    hotspotTable(new QTableWidget(0, 4, this)),
+    chip8(nullptr),
+    profiler(nullptr) {
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    hotspotTable->setHorizontalHeaderLabels({ "Share", "Cycles", "Count", "Instruction" });
+    hotspotTable->horizontalHeader()->setStretchLastSection(true);
+    hotspotTable->verticalHeader()->hide();
+    hotspotTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    hotspotTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(hotspotTable);
+
+    refreshTimer.setInterval(refreshInterval_ms);
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refreshWhileRunning()));
+    refreshTimer.start();
+}
+
+void ProfilerPane::setTarget(Chip8* targetChip8, Profiler* targetProfiler) {
+    chip8 = targetChip8;
+    profiler = targetProfiler;
+    refresh();
+}
+
+void ProfilerPane::refreshWhileRunning() {
+    if(profiler != nullptr && profiler->isRunning() && isVisible())
+        refresh();
+}
+
+void ProfilerPane::refresh() {
+    if(chip8 == nullptr || profiler == nullptr)
+        return;
+
+    // the emulation thread may be writing memory, disassemble from a copy taken between two frames
+    chip8->snapshot(state);
+    const std::vector<Profiler::Hotspot> hotspots = profiler->getHotspots(hotspotCount);
+
+    hotspotTable->setRowCount(hotspots.size());
+    for(size_t row = 0; row < hotspots.size(); ++row) {
+        const Profiler::Hotspot& hotspot = hotspots[row];
+        const uint16_t address = hotspot.address;
+        const uint16_t opcode = state.memory[address] << 8 | state.memory[(address + 1) & 0xFFF];
+        const std::string columns[] = {
+            format("%6.2f%%", hotspot.share * 100),
+            format("%llu", (unsigned long long)hotspot.cycles),
+            format("%llu", (unsigned long long)hotspot.count),
+            Disassembler::formatLine(address, opcode),
+        };
+        for(int column = 0; column < 4; ++column) {
+            QTableWidgetItem* item = new QTableWidgetItem(QString::fromStdString(columns[column]));
+            item->setTextAlignment(column < 3 ? Qt::AlignRight | Qt::AlignVCenter : Qt::AlignLeft | Qt::AlignVCenter);
+            hotspotTable->setItem(row, column, item);
+        }
+    }
+    hotspotTable->resizeColumnsToContents();
+}
@@ -0,0 +1,36 @@
+#ifndef PROFILER_PANE_HPP
+#define PROFILER_PANE_HPP
+
+#include <QTableWidget>
+#include <QTimer>
+#include <QWidget>
+
+#include "Chip8.hpp"
+#include "Profiler.hpp"
+
+// Hotspot table of the profiler: share of the cycles, cycles, count and disassembly of the hottest instructions
+class ProfilerPane : public QWidget {
+    Q_OBJECT
+public:
+    ProfilerPane(QWidget* parent = nullptr);
+
+    void setTarget(Chip8* targetChip8, Profiler* targetProfiler);
+
+public slots:
+    void refresh();
+
+private slots:
+    void refreshWhileRunning();
+
+private:
+    constexpr static size_t hotspotCount = 32;
+    constexpr static int refreshInterval_ms = 500; // while profiling
+
+    QTableWidget* hotspotTable;
+    QTimer refreshTimer;
+    Chip8* chip8;
+    Profiler* profiler;
+    Chip8::State state;     // memory the instructions are disassembled from
+};
+
+#endif // PROFILER_PANE_HPP
@@ -0,0 +1,207 @@
+#include "RomLibrary.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThreadPool>
+
+#include "Chip8.hpp"
+
+RomLibrary::RomLibrary(const QString& file) :
+    indexFile(file) {
+}
+
+bool RomLibrary::load() {
+    QFile file(indexFile);
+    // no index yet, nothing scanned so far
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if(root["version"].toInt() != indexVersion) {
+        std::cout << indexFile.toStdString() << " is not a ROM library index!" << std::endl;
+        return false;
+    }
+
+    entries.clear();
+    const QJsonObject roms = root["roms"].toObject();
+    for(auto it = roms.begin(); it != roms.end(); ++it) {
+        const QJsonObject rom = it.value().toObject();
+        entries.insert(it.key(), Entry {
+            it.key(),
+            rom["title"].toString(),
+            rom["path"].toString(),
+            rom["size"].toInteger(),
+            rom["modified"].toInteger(),
+            rom["displayWait"].toBool(),
+            rom["clockScale"].toDouble(1.0)
+        });
+    }
+    return true;
+}
+
+bool RomLibrary::save() {
+    QJsonObject roms;
+    for(const Entry& entry : entries) {
+        roms.insert(entry.hash, QJsonObject {
+            { "title", entry.title },
+            { "path", entry.path },
+            { "size", entry.size },
+            { "modified", entry.modified },
+            { "displayWait", entry.displayWait },
+            { "clockScale", entry.clockScale }
+        });
+    }
+    const QJsonObject root {
+        { "version", indexVersion },
+        { "roms", roms }
+    };
+
+    // QSaveFile writes to a temporary file and renames it, so the index is never left half written
+    QDir().mkpath(QFileInfo(indexFile).absolutePath());
+    QSaveFile file(indexFile);
+    if(!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(root).toJson()) < 0 || !file.commit()) {
+        std::cout << "Could not write ROM library index " << indexFile.toStdString() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int RomLibrary::scan(const QString& directory) {
+    struct File {
+        QString path;
+        qint64 size;
+        qint64 modified;
+        QString hash;
+    };
+
+    QHash<QString, QString> hashByPath;
+    for(const Entry& entry : entries)
+        hashByPath.insert(entry.path, entry.hash);
+
+    std::vector<File> files;
+    QDirIterator it(directory, { "*.ch8", "*.c8" }, QDir::Files, QDirIterator::Subdirectories);
+    while(it.hasNext()) {
+        const QFileInfo info = it.nextFileInfo();
+        File file { info.absoluteFilePath(), info.size(), info.lastModified().toMSecsSinceEpoch(), {} };
+
+        // unchanged since the last scan, no need to read it
+        const auto known = entries.constFind(hashByPath.value(file.path));
+        if(known != entries.constEnd() && known->size == file.size && known->modified == file.modified)
+            file.hash = known->hash;
+        files.push_back(file);
+    }
+
+    // every task writes its own File only
+    QThreadPool pool;
+    for(File& file : files) {
+        if(file.hash.isEmpty())
+            pool.start([&file] { file.hash = hashFile(file.path); });
+    }
+    pool.waitForDone();
+
+    int found = 0;
+    for(const File& file : files) {
+        if(file.hash.isEmpty())
+            continue;
+        found++;
+
+        auto entry = entries.find(file.hash);
+        if(entry == entries.end()) {
+            entries.insert(file.hash, Entry {
+                file.hash, QFileInfo(file.path).completeBaseName(), file.path, file.size, file.modified, false, 1.0 });
+            continue;
+        }
+        // moved, copied or touched: same ROM, so title and profile stay
+        entry->path = file.path;
+        entry->size = file.size;
+        entry->modified = file.modified;
+    }
+
+    // ROMs whose file is gone
+    for(auto entry = entries.begin(); entry != entries.end();)
+        entry = QFileInfo::exists(entry->path) ? std::next(entry) : entries.erase(entry);
+
+    return found;
+}
+
+std::vector<RomLibrary::Entry> RomLibrary::getEntries() {
+    std::vector<Entry> sorted(entries.begin(), entries.end());
+    std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) {
+        return QString::compare(a.title, b.title, Qt::CaseInsensitive) < 0;
+    });
+    return sorted;
+}
+
+const RomLibrary::Entry* RomLibrary::find(const QString& hash) {
+    const auto entry = entries.constFind(hash);
+    return entry != entries.constEnd() ? &*entry : nullptr;
+}
+
+bool RomLibrary::setTitle(const QString& hash, const QString& title) {
+    auto entry = entries.find(hash);
+    if(entry == entries.end())
+        return false;
+    entry->title = title;
+    return true;
+}
+
+bool RomLibrary::setProfile(const QString& hash, const bool displayWait, const double clockScale) {
+    auto entry = entries.find(hash);
+    if(entry == entries.end())
+        return false;
+    entry->displayWait = displayWait;
+    entry->clockScale = clockScale;
+    return true;
+}
+
+bool RomLibrary::loadRom(const Entry& entry, Chip8& chip8) {
+    QFile file(entry.path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        std::cout << "Could not open " << entry.path.toStdString() << std::endl;
+        return false;
+    }
+
+    const qint64 size = file.size();
+    uchar* data = size > 0 ? file.map(0, size) : nullptr;
+    if(data == nullptr) {
+        std::cout << "Could not map " << entry.path.toStdString() << std::endl;
+        return false;
+    }
+    const bool loaded = chip8.loadFile(data, size);
+    file.unmap(data);
+    if(!loaded)
+        return false;
+
+    chip8.setDisplayWait(entry.displayWait);
+    chip8.setClockScale(entry.clockScale);
+    return true;
+}
+
+QString RomLibrary::hashFile(const QString& path) {
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        std::cout << "Could not read " << path.toStdString() << std::endl;
+        return {};
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint64 size = file.size();
+    if(uchar* data = size > 0 ? file.map(0, size) : nullptr) {
+        hash.addData(QByteArrayView(data, size));
+        file.unmap(data);
+    }
+    else {
+        hash.addData(&file);
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
@@ -0,0 +1,55 @@
+#ifndef ROM_LIBRARY_HPP
+#define ROM_LIBRARY_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <QHash>
+#include <QString>
+
+class Chip8;
+
+/* Persistent index of a ROM collection, keyed by the SHA-1 of the ROM content.
+     * + scan() walks a directory tree and hashes new or changed files in parallel, unchanged files (same path, size
+     *   and modification time) are taken from the index without being read
+     * + every ROM keeps its title and quirk profile across rescans, renames and moves, since the hash identifies it
+     * + the index is a JSON file, see save()
+     * + ROMs are loaded from a memory mapping straight into Memory, without an intermediate QByteArray*/
+
+class RomLibrary {
+public:
+    struct Entry {
+        QString hash;           // SHA-1 of the ROM content, hex
+        QString title;          // file name without suffix until renamed
+        QString path;
+        qint64 size;
+        qint64 modified;        // ms since epoch
+        bool displayWait;       // see Chip8::setDisplayWait
+        double clockScale;      // see Chip8::setClockScale, takes the place of instructions per frame
+    };
+
+    RomLibrary(const QString& indexFile);
+    ~RomLibrary() = default;
+
+    bool load();
+    bool save();
+    int scan(const QString& directory); // returns the number of ROMs found
+
+    std::vector<Entry> getEntries(); // sorted by title
+    const Entry* find(const QString& hash);
+    bool setTitle(const QString& hash, const QString& title);
+    bool setProfile(const QString& hash, const bool displayWait, const double clockScale);
+
+    // loads the ROM into chip8 and applies its quirk profile
+    bool loadRom(const Entry& entry, Chip8& chip8);
+
+    static QString hashFile(const QString& path);
+
+private:
+    static constexpr int indexVersion = 1;
+
+    QString indexFile;
+    QHash<QString, Entry> entries;
+};
+
+#endif // ROM_LIBRARY_HPP
@@ -1,39 +1,42 @@
 #include "Screen.hpp"
 
 #include <cstdint>
-#include <memory>
-
-QReadWriteLock Screen::pixelsLock_;
-std::shared_ptr<std::array<std::array<bool, Screen::yRes_>, Screen::xRes_>> Screen::pixels_;
 
 Screen::Screen() {
-    // set pixel position 
-    pixelsLock_.lockForWrite();
-    pixels_ = std::make_shared<std::array<std::array<bool, yRes_>, xRes_>>();
-    pixelsLock_.unlock();
     clear();
 }
 
 void Screen::clear() {
-    pixelsLock_.lockForRead();
-    for(uint16_t i = 0; i < yRes_; ++i) {
-        for(uint16_t j = 0; j < xRes_; ++j) {
-            (*pixels_)[j][i] = false;
-        }
-    }
+    pixelsLock_.lockForWrite();
+    pixels_.fill(0);
     pixelsLock_.unlock();
 }
 
 bool Screen::getPixel(const uint16_t& x, const uint16_t& y) {
     pixelsLock_.lockForRead();
-    bool pixel = (*pixels_)[x][y];
+    bool pixel = (pixels_[y] >> x) & 1;
     pixelsLock_.unlock();
     return pixel;
 }
 
 void Screen::setPixel(const uint16_t& x, const uint16_t& y, const bool state) {
     pixelsLock_.lockForWrite();
-    (*pixels_)[x][y] = state;
+    if(state)
+        pixels_[y] |= uint64_t(1) << x;
+    else
+        pixels_[y] &= ~(uint64_t(1) << x);
+    pixelsLock_.unlock();
+}
+
+Screen::Frame Screen::getFrame() {
+    pixelsLock_.lockForRead();
+    Frame frame = pixels_;
     pixelsLock_.unlock();
+    return frame;
 }
 
+void Screen::setFrame(const Frame& frame) {
+    pixelsLock_.lockForWrite();
+    pixels_ = frame;
+    pixelsLock_.unlock();
+}
@@ -1,30 +1,30 @@
 #ifndef DISPLAY_HPP
 #define DISPLAY_HPP
 
+#include <array>
 #include <cstdint>
-#include <memory>
 
 #include <QReadWriteLock>
 
 struct Screen {
+    static constexpr uint16_t   xRes_ = 64;
+    static constexpr uint16_t   yRes_ = 32;
+    static constexpr uint16_t   pixelSize_ = 10;
+
+    // 1-bit framebuffer, one 64-bit word per row, bit x of row y is pixel (x, y)
+    using Frame = std::array<uint64_t, yRes_>;
+
     Screen();
     ~Screen() = default;
 
     void clear();
-    static bool getPixel(const uint16_t& x, const uint16_t& y);
-    static void setPixel(const uint16_t& x, const uint16_t& y, bool state);
+    bool getPixel(const uint16_t& x, const uint16_t& y);
+    void setPixel(const uint16_t& x, const uint16_t& y, bool state);
+    Frame getFrame();
+    void setFrame(const Frame& frame);
 
-    static constexpr uint16_t   xRes_ = 64;
-    static constexpr uint16_t   yRes_ = 32;
-    static constexpr uint16_t   pixelSize_ = 10;
-
-    static QReadWriteLock pixelsLock_;
-    static  std::shared_ptr<
-                std::array<
-                    std::array<bool, Screen::yRes_>,
-                Screen::xRes_>>
-            pixels_;
+    QReadWriteLock pixelsLock_;
+    Frame pixels_;
 };
 
 #endif // DISPLAY_HPP
-
@@ -0,0 +1,140 @@
+#include "SharedStateExporter.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Chip8.hpp"
+
+namespace {
+
+// A segment whose emulator died without close(), e.g. after a crash. Segments still being initialized or with a
+// live owner are not stale.
+bool isStale(const std::string& name) {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+        return false;
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    if(fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(Chip8SharedState)))
+        mapping = mmap(nullptr, sizeof(Chip8SharedState), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+        return false;
+
+    const Chip8SharedState* existing = static_cast<const Chip8SharedState*>(mapping);
+    const uint32_t magic = std::atomic_ref<const uint32_t>(existing->magic).load(std::memory_order_acquire);
+    const bool stale = magic == CHIP8_SHARED_STATE_MAGIC && kill(static_cast<pid_t>(existing->pid), 0) < 0
+        && errno == ESRCH;
+    munmap(mapping, sizeof(Chip8SharedState));
+    return stale;
+}
+
+}
+
+SharedStateExporter::SharedStateExporter() :
+    shared(nullptr),
+    frameCount(0) {
+}
+
+SharedStateExporter::~SharedStateExporter() {
+    close();
+}
+
+bool SharedStateExporter::open(const std::string& name) {
+    close();
+
+    // Exclusive, a second writer would break the seqlock of the emulator owning the segment. From here on the name
+    // is ours and may be unlinked.
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0 && errno == EEXIST && isStale(name)) {
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if(fd < 0) {
+        if(errno == EEXIST)
+            std::cout << "Shared memory " << name << " is used by another emulator!" << std::endl;
+        else
+            std::cout << "Could not create shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if(ftruncate(fd, sizeof(Chip8SharedState)) < 0) {
+        std::cout << "Could not create shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, sizeof(Chip8SharedState), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+    if(mapping == MAP_FAILED) {
+        std::cout << "Could not map shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    shared = static_cast<Chip8SharedState*>(mapping);
+    std::memset(shared, 0, sizeof(Chip8SharedState));
+    shared->version = CHIP8_SHARED_STATE_VERSION;
+    shared->size = sizeof(Chip8SharedState);
+    shared->pid = getpid();
+    // readers check the magic last, so they never see a half initialized header
+    std::atomic_ref<uint32_t>(shared->magic).store(CHIP8_SHARED_STATE_MAGIC, std::memory_order_release);
+
+    segmentName = name;
+    frameCount = 0;
+    return true;
+}
+
+void SharedStateExporter::close() {
+    if(shared == nullptr)
+        return;
+
+    munmap(shared, sizeof(Chip8SharedState));
+    shm_unlink(segmentName.c_str());
+    shared = nullptr;
+    segmentName.clear();
+}
+
+uint16_t SharedStateExporter::getKeys() {
+    if(shared == nullptr)
+        return 0;
+    return std::atomic_ref<uint32_t>(shared->inputKeys).load(std::memory_order_acquire);
+}
+
+void SharedStateExporter::publish(Chip8& chip8) {
+    if(shared == nullptr)
+        return;
+    frameCount++;
+    const Screen::Frame frame = chip8.getScreen().getFrame();
+
+    // seqlock: odd while writing, readers retry when the sequence changed under them
+    std::atomic_ref<uint32_t> sequence(shared->sequence);
+    const uint32_t begin = sequence.load(std::memory_order_relaxed);
+    sequence.store(begin + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    shared->frameCount = frameCount;
+    shared->pc = chip8.getPc();
+    shared->I = chip8.getI();
+    shared->sp = chip8.getSp();
+    shared->delayTimer = chip8.getDelayTimer();
+    shared->soundTimer = chip8.getSoundTimer();
+    for(uint8_t r = 0; r < 16; r++) {
+        shared->V[r] = chip8.getV(r);
+        shared->stack[r] = chip8.getStack(r);
+    }
+    shared->paused = chip8.isPaused();
+    shared->waitingForKey = chip8.getIsWaitingForKeyboardInput();
+    std::memcpy(shared->frame, frame.data(), sizeof(shared->frame));
+
+    sequence.store(begin + 2, std::memory_order_release);
+}
@@ -0,0 +1,38 @@
+#ifndef SHARED_STATE_EXPORTER_HPP
+#define SHARED_STATE_EXPORTER_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "SharedStateLayout.h"
+
+class Chip8;
+
+/* Publishes the framebuffer, registers and frame counter of one Chip8 into a POSIX shared memory segment.
+     * + the emulation thread writes every frame under a seqlock, it never waits for readers
+     * + readers in other processes map the segment and copy a snapshot, see SharedStateLayout.h
+     * + keys written into the segment are pressed in addition to the local keypad*/
+
+class SharedStateExporter {
+public:
+    SharedStateExporter();
+    ~SharedStateExporter();
+
+    // name as for shm_open, e.g. "/chip8-state". Fails while another emulator owns the name, a segment left
+    // behind by a dead emulator is replaced.
+    bool open(const std::string& name);
+    void close();                       // also removes the name, mapped readers keep their view. Detach it from
+                                        // the Chip8 first (Chip8::setSharedStateExporter(nullptr))
+    inline bool isOpen() { return shared != nullptr; }
+
+    // called from the emulation thread
+    uint16_t getKeys();
+    void publish(Chip8& chip8);
+
+private:
+    Chip8SharedState* shared;
+    std::string segmentName;
+    uint64_t frameCount;
+};
+
+#endif // SHARED_STATE_EXPORTER_HPP
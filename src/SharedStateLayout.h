@@ -0,0 +1,71 @@
+#ifndef SHARED_STATE_LAYOUT_H
+#define SHARED_STATE_LAYOUT_H
+
+/* Layout of the POSIX shared memory segment published by SharedStateExporter, plain C so that any local process
+     * can map it: shm_open(name, O_RDWR), mmap(sizeof(Chip8SharedState), PROT_READ | PROT_WRITE, MAP_SHARED).
+     * + everything before inputKeys is written by the emulator once per frame under the seqlock in sequence,
+     *   read it with chip8_shared_state_read()
+     * + inputKeys is written by consumers, the emulator ORs it with its own keypad at the start of every frame
+     * + the emulator section and the input section are on separate cache lines*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CHIP8_SHARED_STATE_MAGIC    0x43385353u /* "C8SS" */
+#define CHIP8_SHARED_STATE_VERSION  1u
+
+typedef struct Chip8SharedState {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;              /* sizeof(Chip8SharedState) */
+    uint32_t pid;               /* of the emulator */
+
+    uint32_t sequence;          /* odd while the emulator is writing */
+    uint32_t reserved;
+    uint64_t frameCount;        /* frames emulated since the segment was opened */
+
+    uint16_t pc;
+    uint16_t I;
+    uint16_t sp;
+    uint8_t  delayTimer;
+    uint8_t  soundTimer;
+    uint8_t  V[16];
+    uint16_t stack[16];
+    uint8_t  paused;            /* stopped by the debugger in this frame */
+    uint8_t  waitingForKey;     /* blocked in FX0A */
+    uint8_t  padding0[6];
+
+    uint64_t frame[32];         /* one row per word, bit x of row y is pixel (x, y) */
+    uint8_t  padding1[32];
+
+    uint32_t inputKeys;         /* bit k set = key k is down, written by consumers */
+    uint8_t  padding2[60];
+} Chip8SharedState;
+
+#ifdef __cplusplus
+static_assert(offsetof(Chip8SharedState, inputKeys) % 64 == 0, "inputKeys has to start a cache line");
+static_assert(sizeof(Chip8SharedState) == 448, "the layout is shared with other processes");
+#else
+_Static_assert(offsetof(Chip8SharedState, inputKeys) % 64 == 0, "inputKeys has to start a cache line");
+_Static_assert(sizeof(Chip8SharedState) == 448, "the layout is shared with other processes");
+#endif
+
+/* Copies a consistent snapshot of the emulator section into snapshot, retrying while a frame is being published */
+static inline void chip8_shared_state_read(const Chip8SharedState* shared, Chip8SharedState* snapshot) {
+    for(;;) {
+        const uint32_t begin = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+        if(begin & 1)
+            continue;
+        memcpy(snapshot, (const void*)shared, offsetof(Chip8SharedState, inputKeys));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) == begin)
+            return;
+    }
+}
+
+static inline void chip8_shared_state_set_keys(Chip8SharedState* shared, const uint16_t keys) {
+    __atomic_store_n(&shared->inputKeys, keys, __ATOMIC_RELEASE);
+}
+
+#endif /* SHARED_STATE_LAYOUT_H */
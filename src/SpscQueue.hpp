@@ -0,0 +1,45 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/* Lock-free single producer / single consumer ring buffer.
+     * + push() is only called from the producer thread, pop() only from the consumer thread
+     * + neither side ever blocks, push() fails when the queue is full*/
+
+template<typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of 2");
+public:
+    bool push(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - head_.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_.load(std::memory_order_acquire))
+            return false;
+        item = items[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    inline bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    // head and tail on separate cache lines, so producer and consumer don't false-share
+    alignas(64) std::atomic<size_t> head_ {0};
+    alignas(64) std::atomic<size_t> tail_ {0};
+    alignas(64) std::array<T, Capacity> items;
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,179 @@
+#include "StateExplorer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include <QThread>
+
+#include "WordHash.hpp"
+
+StateExplorer::StateExplorer(Chip8& source, const Options& explorerOptions) :
+    options(explorerOptions),
+    expandedStates(0),
+    duplicateStates(0),
+    crashedStates(0) {
+    if(options.inputChoices.empty()) {
+        options.inputChoices.push_back(0);
+        for(uint16_t key = 0; key < 16; ++key)
+            options.inputChoices.push_back(1 << key);
+    }
+    if(options.threadCount == 0)
+        options.threadCount = std::max(1, QThread::idealThreadCount());
+    options.beamWidth = std::max<uint32_t>(options.beamWidth, 1);
+    threadPool.setMaxThreadCount(options.threadCount);
+
+    source.saveState(root);
+
+    // Worst case per worker: the whole surviving frontier lives in its pool, plus the children of its share of it.
+    // So fork() never runs out.
+    const size_t share = (options.beamWidth + options.threadCount - 1) / options.threadCount;
+    const size_t childCount = share * options.inputChoices.size();
+
+    for(uint32_t i = 0; i < options.threadCount; ++i) {
+        auto worker = std::make_unique<Chip8>();
+        worker->setClockScale(source.getClockScale());
+        worker->setDisplayWait(source.getDisplayWait());
+        workers.push_back(std::move(worker));
+        pools.push_back(std::make_unique<StatePool>(options.beamWidth + childCount));
+        candidates.emplace_back();
+        candidates.back().reserve(childCount);
+    }
+    frontier.reserve(options.beamWidth);
+}
+
+bool StateExplorer::search(const Goal& goal, const Score& score) {
+    steps.clear();
+    seen.clear();
+    solution.clear();
+    frontier.clear();
+    expandedStates = 0;
+    duplicateStates = 0;
+    crashedStates = 0;
+
+    Node rootNode { pools[0]->allocate(), 0, 0 };
+    *rootNode.state = root;
+    steps.push_back({ noParent, 0 });
+    seen.insert(hashState(root));
+
+    if(goal(root)) {
+        release(rootNode);
+        return true;
+    }
+    frontier.push_back(rootNode);
+
+    std::vector<Candidate> next;
+    bool found = false;
+
+    for(uint32_t depth = 0; depth < options.maxDepth && !frontier.empty(); ++depth) {
+        for(uint32_t w = 0; w < options.threadCount; ++w)
+            threadPool.start([this, w, &goal, &score] { expand(w, goal, score); });
+        threadPool.waitForDone();
+
+        // Merge in worker order, so the result does not depend on thread scheduling
+        next.clear();
+        uint32_t goalStep = noParent;
+        for(auto& workerCandidates : candidates) {
+            for(Candidate& candidate : workerCandidates) {
+                expandedStates++;
+                if(candidate.isCrashed) {
+                    crashedStates++;
+                    continue;
+                }
+                if(!seen.insert(candidate.hash).second) {
+                    duplicateStates++;
+                    release(candidate.node);
+                    continue;
+                }
+
+                candidate.node.step = steps.size();
+                steps.push_back({ candidate.parentStep, candidate.input });
+                if(candidate.isGoal && goalStep == noParent)
+                    goalStep = candidate.node.step;
+                next.push_back(candidate);
+            }
+        }
+
+        for(const Node& node : frontier)
+            release(node);
+        frontier.clear();
+
+        if(goalStep != noParent) {
+            buildSolution(goalStep);
+            for(const Candidate& candidate : next)
+                release(candidate.node);
+            found = true;
+            break;
+        }
+
+        if(next.size() > options.beamWidth) {
+            if(score) {
+                std::nth_element(next.begin(), next.begin() + options.beamWidth, next.end(),
+                    [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+            }
+            for(auto it = next.begin() + options.beamWidth; it != next.end(); ++it)
+                release(it->node);
+            next.resize(options.beamWidth);
+        }
+
+        for(const Candidate& candidate : next)
+            frontier.push_back(candidate.node);
+    }
+
+    for(const Node& node : frontier)
+        release(node);
+    frontier.clear();
+    return found;
+}
+
+void StateExplorer::expand(const uint32_t worker, const Goal& goal, const Score& score) {
+    Chip8& chip8 = *workers[worker];
+    StatePool& pool = *pools[worker];
+    std::vector<Candidate>& workerCandidates = candidates[worker];
+    workerCandidates.clear();
+
+    for(size_t i = worker; i < frontier.size(); i += options.threadCount) {
+        const Node& parent = frontier[i];
+
+        for(const uint16_t input : options.inputChoices) {
+            chip8.loadState(*parent.state);
+            chip8.emulateFrame(input);
+
+            Candidate candidate {};
+            candidate.parentStep = parent.step;
+            candidate.input = input;
+            candidate.isCrashed = chip8.isCrashed();
+            if(!candidate.isCrashed) {
+                candidate.node = { chip8.fork(pool), worker, 0 };
+                candidate.hash = hashState(*candidate.node.state);
+                candidate.score = score ? score(*candidate.node.state) : 0;
+                candidate.isGoal = goal(*candidate.node.state);
+            }
+            workerCandidates.push_back(candidate);
+        }
+    }
+}
+
+void StateExplorer::release(const Node& node) {
+    pools[node.pool]->release(node.state);
+}
+
+void StateExplorer::buildSolution(uint32_t step) {
+    solution.clear();
+    for(; steps[step].parent != noParent; step = steps[step].parent)
+        solution.push_back(steps[step].input);
+    std::reverse(solution.begin(), solution.end());
+}
+
+uint64_t StateExplorer::hashState(const Chip8::State& state) {
+    // fields are hashed one by one because State has padding
+    WordHash hash;
+    hash.add(state.pc | uint64_t(state.I) << 16 | uint64_t(state.sp) << 32
+        | uint64_t(state.delayTimer) << 48 | uint64_t(state.soundTimer) << 56);
+    hash.add(state.rngState | uint64_t(state.isWaitingForKeyboardInput) << 32);
+    hash.add(state.cycleBalance);
+    hash.addBytes(state.V, sizeof(state.V));
+    hash.addBytes(state.stack, sizeof(state.stack));
+    hash.addBytes(state.memory.data(), state.memory.size());
+    hash.addBytes(state.frame.data(), sizeof(state.frame));
+    return hash.finish();
+}
@@ -0,0 +1,90 @@
+#ifndef STATE_EXPLORER_HPP
+#define STATE_EXPLORER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include <QThreadPool>
+
+#include "Chip8.hpp"
+#include "StatePool.hpp"
+
+/* Breadth-first / beam search over keypad inputs, one input choice per emulated frame.
+     * + every level forks each frontier state once per input choice, spread over all cores
+     * + states are deduplicated by hash, so input sequences leading to the same machine state are only expanded once
+     * + a branch executing an unknown opcode crashes only its worker's Chip8 and is pruned
+     * + with a score function only the beamWidth best states survive a level, otherwise the first beamWidth in BFS order*/
+
+class StateExplorer {
+public:
+    using Goal = std::function<bool(const Chip8::State&)>;
+    using Score = std::function<int64_t(const Chip8::State&)>;
+
+    struct Options {
+        uint32_t maxDepth = 600;                // frames
+        uint32_t beamWidth = 1024;              // pools hold beamWidth * (threadCount + inputChoices) states
+        uint32_t threadCount = 0;               // 0 = one per core
+        std::vector<uint16_t> inputChoices;     // keypad masks, empty = no key and every single key
+    };
+
+    StateExplorer(Chip8& source, const Options& options);
+    ~StateExplorer() = default;
+
+    // Goal and score are called from worker threads
+    bool search(const Goal& goal, const Score& score = {});
+    inline const std::vector<uint16_t>& getSolution() { return solution; }
+    inline uint64_t getExpandedStates() { return expandedStates; }
+    inline uint64_t getDuplicateStates() { return duplicateStates; }
+    inline uint64_t getCrashedStates() { return crashedStates; } // pruned after an unknown opcode
+
+    static uint64_t hashState(const Chip8::State& state);
+
+private:
+    struct Node {
+        Chip8::State* state;
+        uint32_t pool;
+        uint32_t step;      // index into steps
+    };
+
+    struct Candidate {
+        Node node;
+        uint64_t hash;
+        int64_t score;
+        uint32_t parentStep;
+        uint16_t input;
+        bool isGoal;
+        bool isCrashed;     // no state was forked
+    };
+
+    struct Step {
+        uint32_t parent;
+        uint16_t input;
+    };
+
+    static constexpr uint32_t noParent = UINT32_MAX;
+
+    void expand(const uint32_t worker, const Goal& goal, const Score& score);
+    void release(const Node& node);
+    void buildSolution(uint32_t step);
+
+    Options options;
+    Chip8::State root;
+    QThreadPool threadPool; // one task per worker and level, the threads are reused across levels
+    std::vector<std::unique_ptr<Chip8>> workers;
+    std::vector<std::unique_ptr<StatePool>> pools;
+    std::vector<std::vector<Candidate>> candidates;
+
+    std::vector<Node> frontier;
+    std::vector<Step> steps;
+    std::unordered_set<uint64_t> seen;
+    std::vector<uint16_t> solution;
+
+    uint64_t expandedStates;
+    uint64_t duplicateStates;
+    uint64_t crashedStates;
+};
+
+#endif // STATE_EXPLORER_HPP
@@ -0,0 +1,20 @@
+#include "StatePool.hpp"
+
+StatePool::StatePool(const size_t capacity) :
+    states(capacity) {
+    freeList.reserve(capacity);
+    for(auto it = states.rbegin(); it != states.rend(); ++it)
+        freeList.push_back(&*it);
+}
+
+Chip8::State* StatePool::allocate() {
+    if(freeList.empty())
+        return nullptr;
+    Chip8::State* state = freeList.back();
+    freeList.pop_back();
+    return state;
+}
+
+void StatePool::release(Chip8::State* state) {
+    freeList.push_back(state);
+}
@@ -0,0 +1,25 @@
+#ifndef STATE_POOL_HPP
+#define STATE_POOL_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "Chip8.hpp"
+
+// Fixed-capacity pool of machine states, allocating and releasing never touches the heap
+class StatePool {
+public:
+    StatePool(const size_t capacity);
+    ~StatePool() = default;
+
+    Chip8::State* allocate();
+    void release(Chip8::State* state);
+    inline size_t getCapacity() { return states.size(); }
+    inline size_t getFreeCount() { return freeList.size(); }
+
+private:
+    std::vector<Chip8::State> states;
+    std::vector<Chip8::State*> freeList;
+};
+
+#endif // STATE_POOL_HPP
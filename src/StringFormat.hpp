@@ -0,0 +1,15 @@
+#ifndef STRING_FORMAT_HPP
+#define STRING_FORMAT_HPP
+
+#include <cstdio>
+#include <string>
+
+// snprintf into a std::string, for the short lines of the disassembler, debugger and profiler
+template<typename... Args>
+std::string format(const char* pattern, Args... args) {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), pattern, args...);
+    return buffer;
+}
+
+#endif // STRING_FORMAT_HPP
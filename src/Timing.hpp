@@ -0,0 +1,62 @@
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include <cstdint>
+
+/* Approximate COSMAC VIP instruction timing, in machine cycles (1 machine cycle = 8 clock cycles of the 1.7609 MHz CDP1802).
+     * + every instruction pays the interpreter's fetch/decode loop (fetchCycles) on top of its own execution cost
+     * + a 60 Hz frame has ~3668 machine cycles, ~1024 of which are stolen by the CDP1861 display DMA and interrupt routine
+     * + costs only depend on the opcode, so the scheduler can charge an instruction before it executes*/
+
+struct Timing {
+    static constexpr uint32_t fetchCycles = 68;
+    static constexpr uint32_t frameCycles = 3668;
+    static constexpr uint32_t displayCycles = 1024;
+    static constexpr uint32_t frameBudget = frameCycles - displayCycles;
+    static constexpr uint64_t frameDuration_ns = 16670000;
+
+    static constexpr uint32_t instructionCost(const uint16_t opcode) {
+        const uint16_t x = (opcode & 0x0F00) >> 8;
+        const uint16_t n = opcode & 0x000F;
+
+        switch(opcode & 0xF000) {
+            case 0x0000:
+                switch(opcode) {
+                    case 0x00E0: return fetchCycles + 24 + 3072;    // clear loop over 256 bytes
+                    case 0x00EE: return fetchCycles + 10;
+                    default:     return fetchCycles;
+                }
+            case 0x1000: return fetchCycles + 12;
+            case 0x2000: return fetchCycles + 26;
+            case 0x3000: return fetchCycles + 10;
+            case 0x4000: return fetchCycles + 10;
+            case 0x5000: return fetchCycles + 18;
+            case 0x6000: return fetchCycles + 6;
+            case 0x7000: return fetchCycles + 10;
+            case 0x8000: return fetchCycles + 44;
+            case 0x9000: return fetchCycles + 18;
+            case 0xA000: return fetchCycles + 12;
+            case 0xB000: return fetchCycles + 22;
+            case 0xC000: return fetchCycles + 36;
+            case 0xD000: return fetchCycles + 22 + 46 * n;   // per sprite row shift + store into 2 bytes
+            case 0xE000: return fetchCycles + 18;
+            case 0xF000:
+                switch(opcode & 0x00FF) {
+                    case 0x0007: return fetchCycles + 10;
+                    case 0x000A: return fetchCycles + 19;
+                    case 0x0015: return fetchCycles + 10;
+                    case 0x0018: return fetchCycles + 10;
+                    case 0x001E: return fetchCycles + 16;
+                    case 0x0029: return fetchCycles + 20;
+                    case 0x0033: return fetchCycles + 84 + 16 * 3;
+                    case 0x0055: return fetchCycles + 14 + 14 * (x + 1);
+                    case 0x0065: return fetchCycles + 14 + 14 * (x + 1);
+                    default:     return fetchCycles;
+                }
+            default:
+                return fetchCycles;
+        }
+    }
+};
+
+#endif // TIMING_HPP
@@ -0,0 +1,231 @@
+#include "Upscaler.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include <QMutexLocker>
+
+#include "WordHash.hpp"
+
+namespace {
+
+// spreadN[byte] puts bit i of byte at bit N * i, so N spread rows can be OR-ed into one output row
+template<int N>
+constexpr auto makeSpreadTable() {
+    std::array<uint32_t, 256> table {};
+    for(uint32_t byte = 0; byte < 256; ++byte)
+        for(uint32_t bit = 0; bit < 8; ++bit)
+            table[byte] |= ((byte >> bit) & 1) << (N * bit);
+    return table;
+}
+
+constexpr auto spread2 = makeSpreadTable<2>();
+constexpr auto spread3 = makeSpreadTable<3>();
+
+// bit-wise mask ? a : b
+inline uint64_t pick(const uint64_t mask, const uint64_t a, const uint64_t b) {
+    return (a & mask) | (b & ~mask);
+}
+
+inline uint64_t equal(const uint64_t a, const uint64_t b) {
+    return ~(a ^ b);
+}
+
+// Neighbours within a row, pixels outside the frame repeat the edge pixel
+inline uint64_t leftOf(const uint64_t row) {
+    return row << 1 | (row & 1);
+}
+
+inline uint64_t rightOf(const uint64_t row) {
+    return row >> 1 | (row & (uint64_t(1) << 63));
+}
+
+inline uint8_t byteOf(const uint64_t row, const int i) {
+    return row >> (8 * i);
+}
+
+void storeRow(uint8_t* line, const uint64_t row) {
+    for(int i = 0; i < 8; ++i)
+        line[i] = byteOf(row, i);
+}
+
+void storeRow2(uint8_t* line, const uint64_t left, const uint64_t right) {
+    for(int i = 0; i < 8; ++i) {
+        const uint32_t bits = spread2[byteOf(left, i)] | spread2[byteOf(right, i)] << 1;
+        line[2 * i] = bits;
+        line[2 * i + 1] = bits >> 8;
+    }
+}
+
+void storeRow3(uint8_t* line, const uint64_t left, const uint64_t middle, const uint64_t right) {
+    for(int i = 0; i < 8; ++i) {
+        const uint32_t bits = spread3[byteOf(left, i)] | spread3[byteOf(middle, i)] << 1 | spread3[byteOf(right, i)] << 2;
+        line[3 * i] = bits;
+        line[3 * i + 1] = bits >> 8;
+        line[3 * i + 2] = bits >> 16;
+    }
+}
+
+}
+
+Upscaler::Upscaler() :
+    hasPendingFrame(false),
+    hasLastFrame(false),
+    running(true),
+    filter(Filter::None),
+    filteredFrames(0),
+    cacheHits(0),
+    cache(cacheCapacity),
+    cacheFilter(Filter::None) {
+}
+
+Upscaler::~Upscaler() {
+    stop();
+}
+
+void Upscaler::setFilter(const Filter newFilter) {
+    QMutexLocker locker(&mutex);
+    filter = newFilter;
+    // filter the current frame again, it won't be submitted as long as it doesn't change
+    if(hasLastFrame) {
+        pendingFrame = lastFrame;
+        hasPendingFrame = true;
+        frameSubmitted.wakeOne();
+    }
+    if(newFilter != Filter::None && !isRunning())
+        start();
+}
+
+void Upscaler::submit(const Screen::Frame& frame) {
+    QMutexLocker locker(&mutex);
+    if(hasLastFrame && frame == lastFrame)
+        return;
+
+    lastFrame = frame;
+    hasLastFrame = true;
+    pendingFrame = frame;
+    hasPendingFrame = true;
+    frameSubmitted.wakeOne();
+}
+
+QImage Upscaler::getImage() {
+    QMutexLocker locker(&mutex);
+    return image;
+}
+
+void Upscaler::stop() {
+    mutex.lock();
+    running = false;
+    frameSubmitted.wakeOne();
+    mutex.unlock();
+    wait();
+}
+
+void Upscaler::run() {
+    while(true) {
+        mutex.lock();
+        while(running && !hasPendingFrame)
+            frameSubmitted.wait(&mutex);
+        if(!running) {
+            mutex.unlock();
+            return;
+        }
+        const Screen::Frame frame = pendingFrame;
+        hasPendingFrame = false;
+        mutex.unlock();
+
+        const Filter currentFilter = filter;
+        if(currentFilter != cacheFilter) {
+            cache.clear();
+            cacheFilter = currentFilter;
+        }
+
+        QImage result;
+        const uint64_t hash = hashFrame(frame);
+        const CachedImage* cached = cache.object(hash);
+        if(cached != nullptr && cached->frame == frame) {
+            result = cached->image;
+            cacheHits++;
+        }
+        else {
+            result = render(frame, currentFilter);
+            cache.insert(hash, new CachedImage { frame, result });
+            filteredFrames++;
+        }
+
+        mutex.lock();
+        image = result;
+        mutex.unlock();
+        emit imageReady();
+    }
+}
+
+QImage Upscaler::render(const Screen::Frame& frame, const Filter filter) {
+    const int factor = static_cast<int>(filter);
+    QImage result(Screen::xRes_ * factor, Screen::yRes_ * factor, QImage::Format_MonoLSB);
+    // unlit pixels are black and lit ones transparent, like the unfiltered path which only paints unlit pixels
+    result.setColorTable({ qRgb(0, 0, 0), qRgba(0, 0, 0, 0) });
+    scale(frame, filter, result.bits(), result.bytesPerLine());
+    return result;
+}
+
+// Every step works on a whole row: bit x of E is pixel x, B/H are the rows above/below, D/F the pixels left/right
+void Upscaler::scale(const Screen::Frame& frame, const Filter filter, uint8_t* bits, const qsizetype bytesPerLine) {
+    for(uint16_t y = 0; y < Screen::yRes_; ++y) {
+        const uint64_t E = frame[y];
+        const uint64_t B = y > 0 ? frame[y - 1] : E;
+        const uint64_t H = y + 1 < Screen::yRes_ ? frame[y + 1] : E;
+        const uint64_t D = leftOf(E);
+        const uint64_t F = rightOf(E);
+        // the rules only apply where B != H and D != F
+        const uint64_t active = (B ^ H) & (D ^ F);
+
+        switch(filter) {
+            case Filter::None:
+                storeRow(bits + y * bytesPerLine, E);
+                break;
+            case Filter::Scale2x: {
+                uint8_t* line = bits + 2 * y * bytesPerLine;
+                storeRow2(line,
+                    pick(active & equal(D, B), D, E),
+                    pick(active & equal(B, F), F, E));
+                storeRow2(line + bytesPerLine,
+                    pick(active & equal(D, H), D, E),
+                    pick(active & equal(H, F), F, E));
+                break;
+            }
+            case Filter::Scale3x: {
+                const uint64_t A = leftOf(B);
+                const uint64_t C = rightOf(B);
+                const uint64_t G = leftOf(H);
+                const uint64_t I = rightOf(H);
+                const uint64_t DB = equal(D, B);
+                const uint64_t BF = equal(B, F);
+                const uint64_t DH = equal(D, H);
+                const uint64_t HF = equal(H, F);
+
+                uint8_t* line = bits + 3 * y * bytesPerLine;
+                storeRow3(line,
+                    pick(active & DB, D, E),
+                    pick(active & ((DB & (E ^ C)) | (BF & (E ^ A))), B, E),
+                    pick(active & BF, F, E));
+                storeRow3(line + bytesPerLine,
+                    pick(active & ((DB & (E ^ G)) | (DH & (E ^ A))), D, E),
+                    E,
+                    pick(active & ((BF & (E ^ I)) | (HF & (E ^ C))), F, E));
+                storeRow3(line + 2 * bytesPerLine,
+                    pick(active & DH, D, E),
+                    pick(active & ((DH & (E ^ I)) | (HF & (E ^ G))), H, E),
+                    pick(active & HF, F, E));
+                break;
+            }
+        }
+    }
+}
+
+uint64_t Upscaler::hashFrame(const Screen::Frame& frame) {
+    WordHash hash;
+    for(const uint64_t row : frame)
+        hash.add(row);
+    return hash.finish();
+}
@@ -0,0 +1,72 @@
+#ifndef UPSCALER_HPP
+#define UPSCALER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "Screen.hpp"
+
+/* Pixel-art upscaling of the 1-bit frame on its own thread.
+     * + Scale2x / Scale3x (AdvMAME) rules, evaluated for a whole 64-pixel row at once on the row words
+     * + filtered images are cached by frame hash, so a frame that was already seen is never filtered again
+     * + the GUI thread submits frames and only draws the latest finished image*/
+
+class Upscaler : public QThread {
+    Q_OBJECT
+public:
+    enum class Filter : uint8_t { None = 1, Scale2x = 2, Scale3x = 3 }; // value is the scale factor
+
+    Upscaler();
+    ~Upscaler();
+
+    void setFilter(const Filter newFilter);
+    inline Filter getFilter() { return filter; }
+    void submit(const Screen::Frame& frame); // never waits for filtering
+    QImage getImage();
+    void stop();
+    inline uint64_t getFilteredFrames() { return filteredFrames; }
+    inline uint64_t getCacheHits() { return cacheHits; }
+
+    // lit pixels are 1 in a MonoLSB image, bytesPerLine >= 8 * scale
+    static void scale(const Screen::Frame& frame, const Filter filter, uint8_t* bits, const qsizetype bytesPerLine);
+    static QImage render(const Screen::Frame& frame, const Filter filter);
+    static uint64_t hashFrame(const Screen::Frame& frame);
+
+    void run() override;
+
+signals:
+    void imageReady();
+
+private:
+    struct CachedImage {
+        Screen::Frame frame; // guards against hash collisions
+        QImage image;
+    };
+
+    static constexpr int cacheCapacity = 512; // images, at most 1.2 KB each
+
+    QMutex mutex;
+    QWaitCondition frameSubmitted;
+    Screen::Frame pendingFrame;
+    Screen::Frame lastFrame;
+    bool hasPendingFrame;
+    bool hasLastFrame;
+    bool running;
+    QImage image;
+
+    std::atomic<Filter> filter;
+    std::atomic<uint64_t> filteredFrames;
+    std::atomic<uint64_t> cacheHits;
+
+    // only touched by the worker thread
+    QCache<uint64_t, CachedImage> cache;
+    Filter cacheFilter;
+};
+
+#endif // UPSCALER_HPP
@@ -0,0 +1,42 @@
+#ifndef WORD_HASH_HPP
+#define WORD_HASH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// FNV-1a over 64-bit words with a final avalanche, for in-memory keys (StateExplorer states, Upscaler frames)
+class WordHash {
+public:
+    inline void add(const uint64_t word) {
+        hash ^= word;
+        hash *= prime;
+    }
+
+    // zero-padded to whole words
+    inline void addBytes(const void* data, const size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for(size_t i = 0; i < size; i += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes + i, std::min(sizeof(uint64_t), size - i));
+            add(word);
+        }
+    }
+
+    // FNV on words leaves the low bits weak
+    inline uint64_t finish() const {
+        uint64_t result = hash;
+        result ^= result >> 33;
+        result *= 0xff51afd7ed558ccdull;
+        result ^= result >> 33;
+        return result;
+    }
+
+private:
+    static constexpr uint64_t prime = 1099511628211ull;
+
+    uint64_t hash = 14695981039346656037ull;
+};
+
+#endif // WORD_HASH_HPP